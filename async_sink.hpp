@@ -0,0 +1,150 @@
+#ifndef ASYNC_SINK_HPP
+#define ASYNC_SINK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sink.hpp"
+#include "spsc_queue.hpp"
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// Hands the values to another sink (typically a FileSink) on a background
+// thread, so that the simulation overlaps with the I/O. push() only copies
+// the value into the current block; full blocks travel to the writer
+// through a single-producer/single-consumer queue and come back empty
+// through a second one, so there are at most depth blocks in memory and no
+// allocation after the start. When every block is waiting to be written,
+// push() waits for the writer (back-pressure) instead of growing.
+// An exception thrown by the target sink is rethrown by the next push() or
+// flush(). Only one thread may push.
+template <typename T>
+class AsyncSink : public Sink<T> {
+  enum class Command { Write, Flush, Stop };
+  struct Block {
+    Command command{Command::Write};
+    std::vector<T> values;
+  };
+
+  std::shared_ptr<Sink<T>> target_;
+  std::size_t block_size_;
+  SpscQueue<Block> full_;   // simulation -> writer
+  SpscQueue<Block> empty_;  // writer -> simulation
+  Block current_;
+  std::atomic<std::size_t> flushed_{0};  // flush requests completed
+  std::size_t flushes_{0};               // flush requests sent
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;  // written by the writer before failed_
+  std::thread writer_;
+
+  void write() {
+    while (true) {
+      Block block = full_.pop();
+      if (block.command == Command::Stop) return;
+      if (!failed_.load(std::memory_order_relaxed)) {
+        try {
+          if (block.command == Command::Write) {
+            for (auto const& value : block.values) target_->push(value);
+          } else {
+            target_->flush();
+          }
+        } catch (...) {
+          error_ = std::current_exception();
+          failed_.store(true, std::memory_order_release);
+        }
+      }
+      if (block.command == Command::Flush) {
+        flushed_.fetch_add(1, std::memory_order_release);
+        flushed_.notify_one();
+      } else {
+        block.values.clear();
+        empty_.push(std::move(block));
+      }
+    }
+  }
+
+  void check() const {
+    if (failed_.load(std::memory_order_acquire)) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  void send() {
+    full_.push(std::move(current_));
+    current_ = empty_.pop();
+  }
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  // block_size values per block, depth blocks in total
+  explicit AsyncSink(std::shared_ptr<Sink<T>> target,
+                     std::size_t block_size = 4096, std::size_t depth = 8)
+      : target_(std::move(target)),
+        block_size_(block_size),
+        full_(depth + 1),  // + one command
+        empty_(depth) {
+    if (!target_ || block_size == 0 || depth < 2) {
+      throw std::invalid_argument("Invalid input.");
+    }
+    for (std::size_t i{0}; i < depth; ++i) {
+      Block block;
+      block.values.reserve(block_size);
+      if (i == 0) {
+        current_ = std::move(block);
+      } else {
+        empty_.push(std::move(block));
+      }
+    }
+    writer_ = std::thread{[this] { write(); }};
+  }
+  AsyncSink(AsyncSink const&) = delete;
+  AsyncSink& operator=(AsyncSink const&) = delete;
+
+  // writes what is left; errors are lost, call flush() to see them
+  ~AsyncSink() override {
+    if (!current_.values.empty()) full_.push(std::move(current_));
+    full_.push(Block{Command::Stop, {}});
+    writer_.join();
+  }
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  void push(T const& value) override {
+    current_.values.push_back(value);
+    if (current_.values.size() == block_size_) {
+      // sent before checking, so that a block never outgrows block_size
+      send();
+      check();
+    }
+  }
+
+  // waits until every value pushed so far has reached the target, then
+  // flushes the target
+  void flush() override {
+    if (!current_.values.empty()) send();
+    full_.push(Block{Command::Flush, {}});
+    ++flushes_;
+    std::size_t done = flushed_.load(std::memory_order_acquire);
+    while (done != flushes_) {
+      flushed_.wait(done, std::memory_order_acquire);
+      done = flushed_.load(std::memory_order_acquire);
+    }
+    check();
+  }
+
+  // before the first push() the writer has not touched the target yet
+  void stamp_time() override { target_->stamp_time(); }
+
+  Sink<T>& target() const { return *target_; }
+};
+
+}  // namespace volterra
+
+#endif
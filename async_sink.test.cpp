@@ -0,0 +1,126 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "async_sink.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+#include "doctest.h"
+#include "grid_simulation.hpp"
+#include "simulation.hpp"
+#include "test_files.hpp"
+
+TEST_CASE("Testing SpscQueue") {
+  CHECK_THROWS(volterra::SpscQueue<int>(0));
+
+  volterra::SpscQueue<int> queue(2);
+  int value{1};
+  CHECK(queue.try_push(value));
+  value = 2;
+  CHECK(queue.try_push(value));
+  value = 3;
+  CHECK_FALSE(queue.try_push(value));
+  CHECK(queue.pop() == 1);
+  CHECK(queue.pop() == 2);
+  CHECK_FALSE(queue.try_pop(value));
+
+  // values cross between threads in order, with the queue often full
+  constexpr int n{200000};
+  bool ordered{true};
+  std::thread consumer{[&] {
+    for (int i = 0; i < n; ++i) ordered = ordered && queue.pop() == i;
+  }};
+  for (int i = 0; i < n; ++i) queue.push(i);
+  consumer.join();
+  CHECK(ordered);
+  CHECK_FALSE(queue.try_pop(value));
+}
+
+TEST_CASE("Testing AsyncSink delivers every value in order") {
+  CHECK_THROWS(volterra::AsyncSink<int>(nullptr));
+  auto target = std::make_shared<volterra::VectorSink<int>>();
+  CHECK_THROWS(volterra::AsyncSink<int>(target, 0));
+  CHECK_THROWS(volterra::AsyncSink<int>(target, 16, 1));
+
+  {
+    volterra::AsyncSink<int> sink(target, 7, 3);
+    for (int i = 0; i < 1000; ++i) sink.push(i);
+    sink.flush();
+    REQUIRE(target->data().size() == 1000);
+    for (std::size_t i{0}; i < 1000; ++i) {
+      CHECK(target->data()[i] == static_cast<int>(i));
+    }
+    for (int i = 1000; i < 1003; ++i) sink.push(i);
+  }  // the destructor writes the last partial block
+  CHECK(target->data().size() == 1003);
+}
+
+TEST_CASE("Testing AsyncSink with a slow target") {
+  // the producer is held back instead of queueing without bound
+  std::size_t written{0};
+  auto target = std::make_shared<volterra::CallbackSink<int>>([&](int) {
+    std::this_thread::sleep_for(std::chrono::microseconds(20));
+    ++written;
+  });
+  volterra::AsyncSink<int> sink(target, 10, 2);
+  for (int i = 0; i < 200; ++i) sink.push(i);
+  sink.flush();
+  CHECK(written == 200);
+}
+
+TEST_CASE("Testing AsyncSink reports the errors of the target") {
+  auto target = std::make_shared<volterra::CallbackSink<int>>([](int value) {
+    if (value == 50) throw std::runtime_error("disk full");
+  });
+  volterra::AsyncSink<int> sink(target, 8, 2);
+  CHECK_THROWS_AS(
+      {
+        for (int i = 0; i < 100; ++i) sink.push(i);
+        sink.flush();
+      },
+      std::runtime_error);
+
+  // after the error every full block is still sent, and reports it again
+  std::size_t errors{0};
+  for (int i = 0; i < 80; ++i) {
+    try {
+      sink.push(i);
+    } catch (std::runtime_error const&) {
+      ++errors;
+    }
+  }
+  CHECK(errors == std::size_t(10));
+}
+
+TEST_CASE("Testing simulations streaming to a file") {
+  std::string const expected = temporary("async_expected.csv");
+  std::string const streamed = temporary("async_streamed.csv");
+
+  volterra::Simulation sim({1., 0.5, 0.2, 0.8}, 3., 2., 0.001, 10000.);
+  sim.go();
+  sim.save_evolution(expected);
+
+  volterra::Simulation streaming({1., 0.5, 0.2, 0.8}, 3., 2., 0.001, 10000.);
+  streaming.set_sink(std::make_shared<volterra::AsyncSink<volterra::State>>(
+      std::make_shared<volterra::FileSink<volterra::State>>(streamed,
+                                                            "x\ty\tH")));
+  streaming.go();
+  CHECK(read_file(streamed) == read_file(expected));
+
+  wator::GridSimulation grid({40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1}, 11);
+  grid.go();
+  grid.save_grid_evolution(expected);
+
+  wator::GridSimulation grid_streaming({40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1},
+                                       11);
+  grid_streaming.set_sink(
+      std::make_shared<volterra::AsyncSink<wator::Population>>(
+          std::make_shared<volterra::FileSink<wator::Population>>(
+              streamed, "step\tfish\tsharks"),
+          4));
+  grid_streaming.go();
+  CHECK(read_file(streamed) == read_file(expected));
+
+  std::remove(expected.c_str());
+  std::remove(streamed.c_str());
+}
@@ -0,0 +1,178 @@
+#include "batch.hpp"
+
+#include "async_sink.hpp"
+
+#include <cmath>
+#include <exception>
+#include <istream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace volterra {
+
+namespace {
+
+// READ_VALUE()
+double read_value(std::istringstream& fields) {
+  double value{};
+  if (!(fields >> value)) throw std::invalid_argument("missing value");
+  return value;
+}
+
+// READ_INTEGER()
+// Integers are read as doubles first, so that "-1" or "2.5" are rejected
+// instead of wrapping around or being truncated. The upper bound is the
+// exact power of two 2^digits: max() itself may round up to it as a double.
+template <typename T>
+T read_integer(std::istringstream& fields) {
+  double const value = read_value(fields);
+  if (std::floor(value) != value ||
+      value < static_cast<double>(std::numeric_limits<T>::min()) ||
+      value >= std::ldexp(1., std::numeric_limits<T>::digits)) {
+    throw std::invalid_argument("not an integer in range");
+  }
+  return static_cast<T>(value);
+}
+
+// PARSE_CONTINUOUS()
+ContinuousRun parse_continuous(std::istringstream& fields) {
+  ContinuousRun run{};
+  run.parameters.a = read_value(fields);
+  run.parameters.b = read_value(fields);
+  run.parameters.c = read_value(fields);
+  run.parameters.d = read_value(fields);
+  run.x = read_value(fields);
+  run.y = read_value(fields);
+  run.dt = read_value(fields);
+  run.iterations = read_value(fields);
+  validate(run.parameters, run.x, run.y, run.dt, run.iterations);
+  return run;
+}
+
+// PARSE_GRID()
+GridRun parse_grid(std::istringstream& fields) {
+  GridRun run{};
+  wator::GridParameters& p = run.parameters;
+  p.width = read_integer<std::size_t>(fields);
+  p.height = read_integer<std::size_t>(fields);
+  p.iterations = read_integer<std::size_t>(fields);
+  p.fish_density = read_value(fields);
+  p.sharks_density = read_value(fields);
+  p.fish_breed_age = read_integer<int>(fields);
+  p.sharks_initial_energy = read_integer<int>(fields);
+  p.sharks_breed_energy = read_integer<int>(fields);
+  p.sharks_food_energy = read_integer<int>(fields);
+  p.sharks_move_cost = read_integer<int>(fields);
+  run.seed = read_integer<unsigned>(fields);
+  wator::validate(p);
+  return run;
+}
+
+// STREAM_TO()
+// Without a plot nothing needs the whole run in memory: the rows go to the
+// file on a background thread while the job runs.
+template <typename T>
+std::shared_ptr<Sink<T>> stream_to(std::string const& filename,
+                                   std::string const& header) {
+  return std::make_shared<AsyncSink<T>>(
+      std::make_shared<FileSink<T>>(filename, header));
+}
+
+// RUN_JOB()
+RunResult run_job(Job const& job, bool plot) {
+  RunResult result;
+  try {
+    if (auto const* spec = std::get_if<ContinuousRun>(&job.spec)) {
+      std::string const evolution = job.name + "_EVOLUTION.csv";
+      Simulation sim{spec->parameters, spec->x, spec->y, spec->dt,
+                     spec->iterations};
+      if (!plot) sim.set_sink(stream_to<State>(evolution, "x\ty\tH"));
+      auto const total = static_cast<std::size_t>(sim.iterations());
+      result.outcome = sim.evolve_n(total - sim.steps());
+      if (plot) {
+        sim.save_evolution(evolution);
+        sim.save_plot(job.name + "_PLOT.svg");
+      } else {
+        sim.flush();
+      }
+      result.state = sim.current_state();
+    } else {
+      auto const& grid = std::get<GridRun>(job.spec);
+      std::string const evolution = job.name + "_GRID_EVOLUTION.csv";
+      wator::GridSimulation sim{grid.parameters, grid.seed};
+      if (!plot) {
+        sim.set_sink(
+            stream_to<wator::Population>(evolution, "step\tfish\tsharks"));
+      }
+      result.outcome = sim.evolve_n(sim.iterations() - sim.steps());
+      sim.go();  // completes the history of an empty grid, flushes the sink
+      if (plot) {
+        sim.save_grid_evolution(evolution);
+        sim.save_grid_plot(job.name + "_GRID_PLOT.svg");
+      }
+      result.population = sim.current_population();
+    }
+    result.valid = true;
+  } catch (std::exception const& e) {
+    result.error = e.what();
+  }
+  return result;
+}
+
+}  // namespace
+
+// READ_MANIFEST()
+std::vector<Job> read_manifest(std::istream& in) {
+  std::vector<Job> jobs;
+  std::set<std::string> names;
+  std::string line;
+  std::size_t number{0};
+
+  while (std::getline(in, line)) {
+    ++number;
+    std::istringstream fields{line};
+    std::string kind;
+    if (!(fields >> kind) || kind.front() == '#') continue;
+
+    try {
+      Job job;
+      if (!(fields >> job.name)) throw std::invalid_argument("missing name");
+      // the outputs are written in the current directory only
+      if (job.name.find_first_of("/\\") != std::string::npos ||
+          job.name == "." || job.name == "..") {
+        throw std::invalid_argument("invalid name '" + job.name + "'");
+      }
+      if (kind == "continuous") {
+        job.spec = parse_continuous(fields);
+      } else if (kind == "grid") {
+        job.spec = parse_grid(fields);
+      } else {
+        throw std::invalid_argument("unknown job kind '" + kind + "'");
+      }
+      std::string extra;
+      if (fields >> extra) throw std::invalid_argument("too many values");
+      if (!names.insert(job.name).second) {
+        throw std::invalid_argument("repeated name '" + job.name + "'");
+      }
+      jobs.push_back(std::move(job));
+    } catch (std::invalid_argument const& e) {
+      throw std::invalid_argument("Invalid manifest, line " +
+                                  std::to_string(number) + ": " + e.what());
+    }
+  }
+  return jobs;
+}
+
+// RUN_JOBS()
+std::vector<RunResult> run_jobs(std::vector<Job> const& jobs,
+                                ThreadPool& pool, bool plot) {
+  std::vector<RunResult> results(jobs.size());
+  parallel_for(pool, jobs.size(), [&](std::size_t i) {
+    results[i] = run_job(jobs[i], plot);
+  });
+  return results;
+}
+
+}  // namespace volterra
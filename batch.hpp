@@ -0,0 +1,47 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "runner.hpp"
+#include "thread_pool.hpp"
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+// one line of a manifest; the outputs of the job are named after it
+struct Job {
+  std::string name;
+  RunSpec spec;
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// Reads a job manifest, one job per line (blank lines and lines starting
+// with '#' are skipped):
+//
+//   continuous <name> a b c d x y dt iterations
+//   grid <name> width height iterations fish_density sharks_density
+//        fish_breed_age sharks_initial_energy sharks_breed_energy
+//        sharks_food_energy sharks_move_cost seed
+//
+// Every job is validated before any is run: a malformed line, invalid
+// parameters, a repeated name or one that is not a plain file name (with a
+// path separator, or "." or "..") throw std::invalid_argument naming the
+// line.
+std::vector<Job> read_manifest(std::istream& in);
+
+// Runs the jobs on the pool, writing <name>_EVOLUTION.csv and <name>_PLOT.svg
+// for continuous jobs, <name>_GRID_EVOLUTION.csv and <name>_GRID_PLOT.svg for
+// grid jobs (the plots only if plot is true). The files are the same the
+// interactive mode writes; without plots they are written while the job
+// runs, through an AsyncSink. Returns one result per job, in order.
+std::vector<RunResult> run_jobs(std::vector<Job> const& jobs,
+                                ThreadPool& pool, bool plot = true);
+
+}  // namespace volterra
+
+#endif
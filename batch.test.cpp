@@ -0,0 +1,127 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "batch.hpp"
+
+#include <filesystem>
+#include <sstream>
+
+#include "doctest.h"
+#include "test_files.hpp"
+
+namespace {
+
+void check_rejected(std::string const& manifest) {
+  std::istringstream in{manifest};
+  CHECK_THROWS_AS(volterra::read_manifest(in), std::invalid_argument);
+}
+
+}  // namespace
+
+TEST_CASE("Testing read_manifest()") {
+  std::istringstream in{
+      "# name a b c d x y dt iterations\n"
+      "continuous first 1 0.5 0.2 0.8 3 2 0.001 100\n"
+      "\n"
+      "grid second 40 30 25 0.4 0.02 3 4 10 2 1 11\n"};
+  auto const jobs = volterra::read_manifest(in);
+  REQUIRE(jobs.size() == 2);
+
+  CHECK(jobs[0].name == "first");
+  auto const& continuous = std::get<volterra::ContinuousRun>(jobs[0].spec);
+  CHECK(continuous.parameters == volterra::Parameters{1., 0.5, 0.2, 0.8});
+  CHECK(continuous.x == 3.);
+  CHECK(continuous.y == 2.);
+  CHECK(continuous.dt == 0.001);
+  CHECK(continuous.iterations == 100.);
+
+  CHECK(jobs[1].name == "second");
+  auto const& grid = std::get<volterra::GridRun>(jobs[1].spec);
+  CHECK(grid.parameters ==
+        wator::GridParameters{40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1});
+  CHECK(grid.seed == 11);
+}
+
+TEST_CASE("Testing read_manifest() rejects invalid jobs") {
+  check_rejected("stochastic job 1 2 3\n");
+  check_rejected("continuous\n");
+  check_rejected("continuous job 1 0.5 0.2 0.8 3 2 0.001\n");
+  check_rejected("continuous job 1 0.5 0.2 0.8 3 2 0.001 100 7\n");
+  check_rejected("continuous job 1 0.5 0.2 0.8 -3 2 0.001 100\n");
+  check_rejected("continuous job 1 0.5 0.2 0.8 3 2 0.001 10.5\n");
+  check_rejected("grid job 40 30 25 0.4 0.02 3 4 10 2 1\n");
+  check_rejected("grid job -40 30 25 0.4 0.02 3 4 10 2 1 11\n");
+  check_rejected("grid job 40 30 25 0.8 0.3 3 4 10 2 1 11\n");
+  check_rejected("grid job 40 30 25 0.4 0.02 3 4.5 10 2 1 11\n");
+  // 2^64 would pass a check against size_t max() rounded to a double
+  check_rejected(
+      "grid job 40 30 18446744073709551616 0.4 0.02 3 4 10 2 1 11\n");
+  check_rejected("grid job 40 30 25 0.4 0.02 3 4 10 2 1 4294967296\n");
+  // too many cells for a grid, found before any job runs
+  check_rejected(
+      "grid job 4294967296 4294967296 25 0.4 0.02 3 4 10 2 1 11\n");
+  check_rejected(
+      "continuous job 1 0.5 0.2 0.8 3 2 0.001 100\n"
+      "grid job 40 30 25 0.4 0.02 3 4 10 2 1 11\n");
+  // names become file names
+  check_rejected("continuous ../job 1 0.5 0.2 0.8 3 2 0.001 100\n");
+  check_rejected("continuous a/b 1 0.5 0.2 0.8 3 2 0.001 100\n");
+  check_rejected("continuous a\\b 1 0.5 0.2 0.8 3 2 0.001 100\n");
+  check_rejected("grid .. 40 30 25 0.4 0.02 3 4 10 2 1 11\n");
+  check_rejected("continuous /tmp 1 0.5 0.2 0.8 3 2 0.001 100\n");
+
+  // the error names the offending line
+  std::istringstream in{
+      "continuous good 1 0.5 0.2 0.8 3 2 0.001 100\n"
+      "continuous bad 1 0.5 0.2 0.8 3 2 0 100\n"};
+  try {
+    volterra::read_manifest(in);
+    FAIL("no exception");
+  } catch (std::invalid_argument const& e) {
+    CHECK(std::string{e.what()}.find("line 2") != std::string::npos);
+  }
+}
+
+TEST_CASE("Testing run_jobs() writes the same files as the interactive mode") {
+  auto const directory =
+      std::filesystem::temp_directory_path() / "volterra_batch_test";
+  std::filesystem::create_directories(directory);
+  // the outputs go to the current directory
+  auto const previous = std::filesystem::current_path();
+  std::filesystem::current_path(directory);
+  std::string const prefix = (directory / "").string();
+
+  std::istringstream in{
+      "continuous lv 1 0.5 0.2 0.8 3 2 0.001 500\n"
+      "grid wator 40 30 25 0.4 0.02 3 4 10 2 1 11\n"
+      "grid empty 4 4 30 0.1 0.05 3 1 10 2 5 1\n"};
+  auto const jobs = volterra::read_manifest(in);
+
+  volterra::ThreadPool pool(2);
+  auto const results = volterra::run_jobs(jobs, pool, false);
+  REQUIRE(results.size() == 3);
+  for (auto const& result : results) CHECK(result.valid);
+
+  volterra::Simulation sim({1, 0.5, 0.2, 0.8}, 3, 2, 0.001, 500);
+  sim.go();
+  sim.save_evolution(prefix + "expected.csv");
+  CHECK(read_file(prefix + "lv_EVOLUTION.csv") ==
+        read_file(prefix + "expected.csv"));
+  CHECK(results[0].state == sim.current_state());
+
+  wator::GridSimulation grid({40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1}, 11);
+  grid.go();
+  grid.save_grid_evolution(prefix + "expected_grid.csv");
+  CHECK(read_file(prefix + "wator_GRID_EVOLUTION.csv") ==
+        read_file(prefix + "expected_grid.csv"));
+
+  // an empty grid still gets its full history
+  wator::GridSimulation empty({4, 4, 30, 0.1, 0.05, 3, 1, 10, 2, 5}, 1);
+  empty.go();
+  empty.save_grid_evolution(prefix + "expected_empty.csv");
+  CHECK(read_file(prefix + "empty_GRID_EVOLUTION.csv") ==
+        read_file(prefix + "expected_empty.csv"));
+  CHECK(results[2].outcome.status == volterra::Status::Extinct);
+
+  std::filesystem::current_path(previous);
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,103 @@
+#include "downsample.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace volterra {
+
+// DOWNSAMPLE()
+std::vector<std::size_t> downsample(
+    std::size_t size, std::function<double(std::size_t)> const& x,
+    std::vector<std::function<double(std::size_t)>> const& ys, double x_min,
+    double x_max, std::size_t columns) {
+  if (columns == 0) throw std::invalid_argument("Invalid input.");
+  std::vector<std::size_t> kept;
+  double const scale =
+      x_max > x_min ? static_cast<double>(columns) / (x_max - x_min) : 0.;
+
+  // the column being collected
+  bool open{false};
+  std::size_t column{0};
+  std::size_t first{0};
+  std::size_t last{0};
+  std::vector<std::size_t> lowest(ys.size());
+  std::vector<std::size_t> highest(ys.size());
+  std::vector<double> low(ys.size());
+  std::vector<double> high(ys.size());
+  std::vector<std::size_t> chosen;
+
+  auto close = [&] {
+    if (!open) return;
+    chosen.assign({first, last});
+    chosen.insert(chosen.end(), lowest.begin(), lowest.end());
+    chosen.insert(chosen.end(), highest.begin(), highest.end());
+    std::sort(chosen.begin(), chosen.end());
+    chosen.erase(std::unique(chosen.begin(), chosen.end()), chosen.end());
+    kept.insert(kept.end(), chosen.begin(), chosen.end());
+    open = false;
+  };
+
+  for (std::size_t i{0}; i < size; ++i) {
+    double const xi = x(i);
+    bool finite = std::isfinite(xi);
+    for (std::size_t k{0}; finite && k < ys.size(); ++k) {
+      finite = std::isfinite(ys[k](i));
+    }
+    if (!finite) {
+      close();
+      kept.push_back(i);
+      continue;
+    }
+
+    double const position = std::floor((xi - x_min) * scale);
+    auto const c = static_cast<std::size_t>(
+        std::clamp(position, 0., static_cast<double>(columns - 1)));
+    if (open && c != column) close();
+    if (!open) {
+      open = true;
+      column = c;
+      first = i;
+      for (std::size_t k{0}; k < ys.size(); ++k) {
+        lowest[k] = highest[k] = i;
+        low[k] = high[k] = ys[k](i);
+      }
+    }
+    last = i;
+    for (std::size_t k{0}; k < ys.size(); ++k) {
+      double const yi = ys[k](i);
+      if (yi < low[k]) {
+        low[k] = yi;
+        lowest[k] = i;
+      }
+      if (yi > high[k]) {
+        high[k] = yi;
+        highest[k] = i;
+      }
+    }
+  }
+  close();
+  return kept;
+}
+
+std::vector<std::size_t> downsample(std::span<State const> evolution,
+                                    std::size_t columns) {
+  if (evolution.empty()) return {};
+  return downsample(
+      evolution.size(), [&](std::size_t i) { return evolution[i].t; },
+      {[&](std::size_t i) { return evolution[i].x; },
+       [&](std::size_t i) { return evolution[i].y; }},
+      evolution.front().t, evolution.back().t, columns);
+}
+
+std::vector<std::size_t> downsample(
+    std::span<wator::Population const> history, std::size_t columns) {
+  if (history.empty()) return {};
+  return downsample(
+      history.size(), [](std::size_t i) { return static_cast<double>(i); },
+      {[&](std::size_t i) { return static_cast<double>(history[i].fish); },
+       [&](std::size_t i) { return static_cast<double>(history[i].sharks); }},
+      0., static_cast<double>(history.size() - 1), columns);
+}
+
+}  // namespace volterra
@@ -0,0 +1,35 @@
+#ifndef DOWNSAMPLE_HPP
+#define DOWNSAMPLE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "grid_simulation.hpp"
+#include "simulation.hpp"
+
+namespace volterra {
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// Indices (increasing) of the points to keep so that the lines through the
+// ys, drawn against x over columns pixel columns of [x_min, x_max], look
+// the same as with every point: in each column the first and the last
+// point and, for every y, the lowest and the highest one (M4). x must not
+// decrease. Points that are not finite are kept, they break the lines.
+std::vector<std::size_t> downsample(
+    std::size_t size, std::function<double(std::size_t)> const& x,
+    std::vector<std::function<double(std::size_t)>> const& ys, double x_min,
+    double x_max, std::size_t columns);
+
+// the same for prey and predators against time, over the whole run
+std::vector<std::size_t> downsample(std::span<State const> evolution,
+                                    std::size_t columns);
+// the same for fish and sharks against the step
+std::vector<std::size_t> downsample(
+    std::span<wator::Population const> history, std::size_t columns);
+
+}  // namespace volterra
+
+#endif
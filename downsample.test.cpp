@@ -0,0 +1,101 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "downsample.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "doctest.h"
+#include "svg_plot.hpp"
+
+namespace {
+
+// extrema of y per pixel column, over all the points or the kept ones
+std::vector<std::pair<double, double>> raster(
+    std::vector<double> const& x, std::vector<double> const& y,
+    std::vector<std::size_t> const& indices, std::size_t columns) {
+  std::vector<std::pair<double, double>> extrema(columns,
+                                                 {INFINITY, -INFINITY});
+  double const scale = static_cast<double>(columns) / (x.back() - x.front());
+  for (std::size_t i : indices) {
+    auto c = static_cast<std::size_t>((x[i] - x.front()) * scale);
+    c = std::min(c, columns - 1);
+    extrema[c].first = std::min(extrema[c].first, y[i]);
+    extrema[c].second = std::max(extrema[c].second, y[i]);
+  }
+  return extrema;
+}
+
+}  // namespace
+
+TEST_CASE("Testing downsample() keeps the extrema of every column") {
+  std::size_t const n{1000000};
+  std::size_t const columns{880};
+  std::vector<double> x(n);
+  std::vector<double> y(n);
+  for (std::size_t i{0}; i < n; ++i) {
+    x[i] = 0.001 * static_cast<double>(i);
+    y[i] = std::sin(x[i]) + 0.3 * std::sin(37. * x[i]);
+  }
+  auto const kept = volterra::downsample(
+      n, [&](std::size_t i) { return x[i]; },
+      {[&](std::size_t i) { return y[i]; }}, x.front(), x.back(), columns);
+
+  CHECK(kept.size() <= 4 * columns);
+  CHECK(kept.front() == 0);
+  CHECK(kept.back() == n - 1);
+  CHECK(std::is_sorted(kept.begin(), kept.end()));
+  CHECK(std::adjacent_find(kept.begin(), kept.end()) == kept.end());
+
+  std::vector<std::size_t> all(n);
+  for (std::size_t i{0}; i < n; ++i) all[i] = i;
+  CHECK(raster(x, y, kept, columns) == raster(x, y, all, columns));
+
+  CHECK_THROWS(volterra::downsample(
+      n, [&](std::size_t i) { return x[i]; }, {}, 0., 1., 0));
+}
+
+TEST_CASE("Testing downsample() keeps the breaks") {
+  std::vector<double> const y{1., 2., 3., NAN, 4., 5., 6.};
+  auto const kept = volterra::downsample(
+      y.size(), [](std::size_t i) { return static_cast<double>(i); },
+      {[&](std::size_t i) { return y[i]; }}, 0., 6., 1);
+  CHECK(kept == std::vector<std::size_t>{0, 2, 3, 4, 6});
+}
+
+TEST_CASE("Testing downsample() on simulations") {
+  volterra::Simulation sim({1., 0.5, 0.2, 0.8}, 3., 2., 0.0001, 300000.);
+  sim.go();
+  auto const& evolution = sim.evolution();
+  auto const kept = volterra::downsample(std::span{evolution}, 1000);
+  CHECK(kept.size() <= 6 * 1000);
+  CHECK(kept.front() == 0);
+  CHECK(kept.back() == evolution.size() - 1);
+  double const x_max =
+      std::max_element(evolution.begin(), evolution.end(),
+                       [](auto const& a, auto const& b) { return a.x < b.x; })
+          ->x;
+  CHECK(std::any_of(kept.begin(), kept.end(),
+                    [&](std::size_t i) { return evolution[i].x == x_max; }));
+
+  wator::GridSimulation grid({40, 30, 500, 0.4, 0.02, 3, 4, 10, 2, 1}, 11);
+  grid.go();
+  auto const& history = grid.history();
+  CHECK(volterra::downsample(std::span{history}, 1000).size() ==
+        history.size());  // fewer points than columns: all kept
+  CHECK(volterra::downsample(std::span{history}, 50).size() <= 6 * 50);
+
+  // the plot of the long run stays small
+  std::ostringstream full;
+  std::ostringstream reduced;
+  auto t = [&](std::size_t i) { return evolution[i].t; };
+  auto x = [&](std::size_t i) { return evolution[i].x; };
+  volterra::Series const prey{"PREY", "green", evolution.size(), t, x};
+  volterra::PlotStyle style;
+  style.downsample = false;
+  volterra::write_svg(full, style, {prey});
+  style.downsample = true;
+  volterra::write_svg(reduced, style, {prey});
+  CHECK(reduced.str().size() * 20 < full.str().size());
+}
@@ -0,0 +1,133 @@
+#include "ensemble.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "lane_step.hpp"
+
+namespace volterra {
+
+namespace {
+
+// lanes advanced together for all the requested steps, so that the working
+// set of a block (9 doubles per lane) stays in the L1 cache
+constexpr std::size_t block_lanes{256};
+
+// One step of Simulation::evolve() on lanes [first, last). The loop body has
+// no branches and no calls and the lanes are declared not to alias; the
+// pragma (-fopenmp-simd, see CMakeLists.txt) has it vectorized at -O2 too.
+void step_lanes(double* __restrict__ x, double* __restrict__ y,
+                double const* __restrict__ a, double const* __restrict__ d,
+                double const* __restrict__ dt, double* __restrict__ alive,
+                double* __restrict__ steps, std::size_t first,
+                std::size_t last) {
+#pragma omp simd
+  for (std::size_t i = first; i < last; ++i) {
+    double x_i = x[i];
+    double y_i = y[i];
+    bool const ok = step_lane(x_i, y_i, a[i], d[i], dt[i], alive[i] != 0.0);
+    double const mask = ok ? 1.0 : 0.0;
+
+    x[i] = x_i;
+    y[i] = y_i;
+    alive[i] = mask;
+    steps[i] += mask;
+  }
+}
+
+}  // namespace
+
+//--------------------------PUBLIC FUNCTIONS-----------------------
+
+// ADD()
+std::size_t Ensemble::add(Parameters p_, double x_0, double y_0,
+                          double dt_0) {
+  validate(p_, x_0, y_0, dt_0, 1.);  // a lane has no iteration count
+
+  // Coordinate change, same as Simulation's constructor
+  x_.push_back(x_0 * p_.c / p_.d);
+  y_.push_back(y_0 * p_.b / p_.a);
+  a_.push_back(p_.a);
+  b_.push_back(p_.b);
+  c_.push_back(p_.c);
+  d_.push_back(p_.d);
+  dt_.push_back(dt_0);
+  alive_.push_back(1.0);
+  steps_.push_back(0.0);
+  id_.push_back(next_id_);
+
+  return next_id_++;
+}
+
+// RESERVE()
+void Ensemble::reserve(std::size_t n) {
+  for (auto* lane : {&x_, &y_, &a_, &b_, &c_, &d_, &dt_, &alive_, &steps_})
+    lane->reserve(n);
+  id_.reserve(n);
+}
+
+// COMPACT()
+// Removes the extinct lanes, keeping the relative order of the others.
+void Ensemble::compact() {
+  std::size_t kept{0};
+  for (std::size_t i{0}; i < size(); ++i) {
+    if (alive_[i] == 0.0) continue;
+    x_[kept] = x_[i];
+    y_[kept] = y_[i];
+    a_[kept] = a_[i];
+    b_[kept] = b_[i];
+    c_[kept] = c_[i];
+    d_[kept] = d_[i];
+    dt_[kept] = dt_[i];
+    alive_[kept] = alive_[i];
+    steps_[kept] = steps_[i];
+    id_[kept] = id_[i];
+    ++kept;
+  }
+  for (auto* lane : {&x_, &y_, &a_, &b_, &c_, &d_, &dt_, &alive_, &steps_})
+    lane->resize(kept);
+  id_.resize(kept);
+}
+
+// ALIVE_COUNT()
+std::size_t Ensemble::alive_count() const {
+  return static_cast<std::size_t>(
+      std::count_if(alive_.begin(), alive_.end(),
+                    [](double alive) { return alive != 0.0; }));
+}
+
+// PARAMETERS()
+Parameters Ensemble::parameters(std::size_t lane) const {
+  return Parameters{a_[lane], b_[lane], c_[lane], d_[lane]};
+}
+
+// STATE()
+// Physical coordinates and Hamiltonian of a lane, computed on request only.
+State Ensemble::state(std::size_t lane) const {
+  double const x = x_[lane] * d_[lane] / c_[lane];
+  double const y = y_[lane] * a_[lane] / b_[lane];
+  double const H = (c_[lane] * x) + (b_[lane] * y) -
+                   (d_[lane] * std::log(x)) - (a_[lane] * std::log(y));
+  return State{x, y, H};
+}
+
+// EVOLVE()
+void Ensemble::evolve() { evolve_n(1); }
+
+// EVOLVE_N()
+void Ensemble::evolve_n(std::size_t count) {
+  for (std::size_t first{0}; first < size(); first += block_lanes) {
+    std::size_t const last = std::min(first + block_lanes, size());
+    for (std::size_t step{0}; step < count; ++step) evolve_block(first, last);
+  }
+}
+
+//--------------------------PRIVATE FUNCTIONS-----------------------
+
+// EVOLVE_BLOCK()
+void Ensemble::evolve_block(std::size_t first, std::size_t last) {
+  step_lanes(x_.data(), y_.data(), a_.data(), d_.data(), dt_.data(),
+             alive_.data(), steps_.data(), first, last);
+}
+
+}  // namespace volterra
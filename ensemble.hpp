@@ -0,0 +1,64 @@
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "simulation.hpp"
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// Batch of independent continuous simulations stored as structure-of-arrays.
+// Every lane carries its own parameters, dt and state (in the same relative
+// coordinates used by Simulation), and all lanes are advanced together by a
+// branch-free version of Simulation::evolve() that the compiler can
+// vectorize. A lane that would go extinct is frozen on its last valid state
+// and masked out instead of throwing.
+class Ensemble {
+  // attributes (one entry per lane)
+  std::vector<double> x_;  // prey, relative coordinate x*c/d
+  std::vector<double> y_;  // predator, relative coordinate y*b/a
+  std::vector<double> a_;
+  std::vector<double> b_;
+  std::vector<double> c_;
+  std::vector<double> d_;
+  std::vector<double> dt_;
+  std::vector<double> alive_;  // 1 while the lane evolves, 0 once extinct
+  std::vector<double> steps_;  // steps taken while alive
+  std::vector<std::size_t> id_;  // index returned by add(), kept by compact()
+  std::size_t next_id_{0};
+
+  void evolve_block(std::size_t first, std::size_t last);
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  Ensemble() = default;
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  // lanes
+  std::size_t add(Parameters p_, double x_0, double y_0, double dt_0);
+  void reserve(std::size_t n);
+  void compact();
+
+  // getters
+  std::size_t size() const { return x_.size(); }
+  std::size_t alive_count() const;
+  bool alive(std::size_t lane) const { return alive_[lane] != 0.0; }
+  std::size_t steps(std::size_t lane) const {
+    return static_cast<std::size_t>(steps_[lane]);
+  }
+  std::size_t id(std::size_t lane) const { return id_[lane]; }
+  Parameters parameters(std::size_t lane) const;
+  double timescale(std::size_t lane) const { return dt_[lane]; }
+  State state(std::size_t lane) const;
+
+  // calculations
+  void evolve();
+  void evolve_n(std::size_t count);
+};
+
+}  // namespace volterra
+
+#endif
@@ -0,0 +1,86 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "ensemble.hpp"
+
+#include "doctest.h"
+
+TEST_CASE("Testing add()") {
+  volterra::Ensemble ensemble;
+
+  CHECK_THROWS(ensemble.add({0., 1., 1., 500.}, 1000., 1000., 0.0001));
+  CHECK_THROWS(ensemble.add({400., 1., 1., 500.}, -1000., 1000., 0.0001));
+  CHECK_THROWS(ensemble.add({400., 1., 1., 500.}, 1000., 1000., 0.));
+  CHECK(ensemble.size() == std::size_t(0));
+
+  CHECK(ensemble.add({400., 1., 1., 500.}, 1000., 1000., 0.0001) ==
+        std::size_t(0));
+  CHECK(ensemble.add({2., 1., 1., 3.}, 5., 4., 0.001) == std::size_t(1));
+  REQUIRE(ensemble.size() == std::size_t(2));
+
+  CHECK(ensemble.parameters(1) == volterra::Parameters{2., 1., 1., 3.});
+  CHECK(ensemble.timescale(1) == 0.001);
+  CHECK(ensemble.state(0) == volterra::State{1000., 1000., 0.});
+  CHECK(ensemble.state(0).H ==
+        doctest::Approx(-4216.97975108392).epsilon(1e-10));
+  CHECK(ensemble.alive_count() == std::size_t(2));
+}
+
+TEST_CASE("Testing evolve_n() against Simulation") {
+  std::vector<volterra::Parameters> const parameters{
+      {400., 1., 1., 500.}, {2., 1., 1., 3.}, {1., 0.5, 0.2, 0.7}};
+  double const dt{0.0001};
+  std::size_t const steps{500};
+
+  volterra::Ensemble ensemble;
+  // more lanes than a block, with repeated parameter sets
+  for (std::size_t i{0}; i < 600; ++i) {
+    auto const& p = parameters[i % parameters.size()];
+    ensemble.add(p, 10. + static_cast<double>(i % 7), 20., dt);
+  }
+
+  ensemble.evolve_n(steps);
+
+  for (std::size_t i{0}; i < ensemble.size(); i += 37) {
+    auto const& p = parameters[i % parameters.size()];
+    volterra::Simulation sim(p, 10. + static_cast<double>(i % 7), 20., dt,
+                             static_cast<double>(steps + 1));
+    sim.go();
+
+    CHECK(ensemble.alive(i));
+    CHECK(ensemble.steps(i) == steps);
+    CHECK(ensemble.state(i).x ==
+          doctest::Approx(sim.current_state().x).epsilon(1e-12));
+    CHECK(ensemble.state(i).y ==
+          doctest::Approx(sim.current_state().y).epsilon(1e-12));
+    CHECK(ensemble.state(i).H ==
+          doctest::Approx(sim.current_state().H).epsilon(1e-12));
+  }
+}
+
+TEST_CASE("Testing extinct lanes") {
+  volterra::Ensemble ensemble;
+  ensemble.add({400., 1., 1., 500.}, 1000., 1000., 0.0001);
+  // dt so large that the first step pushes the predators below zero
+  ensemble.add({400., 1., 1., 500.}, 1000., 1000., 1.);
+  ensemble.add({2., 1., 1., 3.}, 5., 4., 0.001);
+
+  CHECK_NOTHROW(ensemble.evolve_n(10));
+
+  CHECK(ensemble.alive(0));
+  CHECK_FALSE(ensemble.alive(1));
+  CHECK(ensemble.alive(2));
+  CHECK(ensemble.steps(1) == std::size_t(0));
+  CHECK(ensemble.state(1) == volterra::State{1000., 1000., 0.});
+  CHECK(ensemble.alive_count() == std::size_t(2));
+
+  SUBCASE("compact() removes extinct lanes and keeps ids") {
+    auto const last = ensemble.state(2);
+    ensemble.compact();
+
+    REQUIRE(ensemble.size() == std::size_t(2));
+    CHECK(ensemble.id(0) == std::size_t(0));
+    CHECK(ensemble.id(1) == std::size_t(2));
+    CHECK(ensemble.state(1) == last);
+    CHECK(ensemble.steps(1) == std::size_t(10));
+  }
+}
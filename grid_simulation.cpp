@@ -2,41 +2,54 @@
 
 #include <algorithm>
 #include <array>
-#include <cstdio>
 #include <cstdlib>
-#include <fstream>
 #include <iostream>
 
+#include "svg_plot.hpp"
+#include "text_export.hpp"
+
 namespace wator {
 
 // COSTRUTTORE
 
 GridSimulation::GridSimulation(GridParameters p, unsigned seed)
-    : parameters_(p), rng_(seed) {
-  if (p.width == 0 || p.height == 0 || p.iterations == 0 ||
-      p.fish_density <= 0 || p.sharks_density <= 0 ||
-      (p.fish_density + p.sharks_density) > 1 || p.fish_density <= 0 ||
-      p.sharks_density <= 0 || p.sharks_initial_energy <= 0 ||
-      p.sharks_food_energy <= 0 || p.sharks_breed_energy <= 0 ||
-      p.sharks_move_cost <= 0) {
-    throw std::invalid_argument("Invalid input.");
+    : parameters_(p),
+      sink_(std::make_shared<volterra::VectorSink<Population>>()),
+      seed_(seed),
+      rng_(seed) {
+  validate(p);
+  age_limit_ = std::max(p.fish_breed_age, 0);
+
+  stride_ = p.width + 2;
+  grid_.resize(stride_ * (p.height + 2));
+  // edge sulle due righe e colonne esterne per lato, cornice compresa
+  for (std::size_t row = 0; row < p.height + 2; ++row) {
+    bool const edge_row{row <= 1 || row >= p.height};
+    for (std::size_t col = 0; col < stride_; ++col) {
+      if (edge_row || col <= 1 || col >= p.width) {
+        grid_[row * stride_ + col].set_edge();
+      }
+    }
   }
 
-  grid_.resize(p.width * p.height);
-
   std::uniform_real_distribution<double> dist(0.0, 1.0);
 
-  for (auto& cell : grid_) {
+  for_each_index([&](std::size_t i) {
     double const r = dist(rng_);
 
     if (r < parameters_.fish_density) {
-      cell.state = CellState::Prey;
+      grid_[i].assign(Cell::prey(0, true));
     } else if (r < parameters_.fish_density + parameters_.sharks_density) {
-      cell.state = CellState::Predator;
-      cell.energy = parameters_.sharks_initial_energy;
+      grid_[i].assign(Cell::predator(parameters_.sharks_initial_energy, true));
     }
-  }
-  history_.push_back(get_population());
+  });
+  refresh_halo();
+  for_each_index([&](std::size_t i) {
+    if (grid_[i].state() != CellState::Empty) written_.push_back(i);
+  });
+  current_ = get_population();
+  steps_ = 1;
+  sink_->push(current_);
 };
 
 // ---------------METODI DELLA CLASSE------------------
@@ -46,91 +59,138 @@ GridSimulation::GridSimulation(GridParameters p, unsigned seed)
 Population GridSimulation::get_population() const {
   Population population;
 
-  for (Cell const& cell : grid_) {
-    if (cell.state == CellState::Prey)
+  for_each_index([&](std::size_t i) {
+    if (grid_[i].state() == CellState::Prey)
       ++population.fish;
-    else if (cell.state == CellState::Predator)
+    else if (grid_[i].state() == CellState::Predator)
       ++population.sharks;
-  }
+  });
 
   return population;
 }
 
-// UP DOWN LEFT RIGHT
+// INDEX E CORNICE
 
 std::size_t GridSimulation::index(std::size_t row, std::size_t col) const {
-  return row * parameters_.width + col;
-}
-
-Cell& GridSimulation::current_cell(size_t row, size_t column) {
-  return grid_[index(row, column)];
-};
-
-std::size_t GridSimulation::up(std::size_t row) const {
-  return (row + parameters_.height - 1) % parameters_.height;
+  return (row + 1) * stride_ + col + 1;
 }
 
-std::size_t GridSimulation::down(std::size_t row) const {
-  return (row + 1) % parameters_.height;
+// copia nella cornice le righe e le colonne del lato opposto
+void GridSimulation::refresh_halo() {
+  std::size_t const h{parameters_.height};
+  std::size_t const w{parameters_.width};
+  for (std::size_t col = 1; col <= w; ++col) {
+    grid_[col].assign(grid_[h * stride_ + col]);
+    grid_[(h + 1) * stride_ + col].assign(grid_[stride_ + col]);
+  }
+  for (std::size_t row = 1; row <= h; ++row) {
+    grid_[row * stride_].assign(grid_[row * stride_ + w]);
+    grid_[row * stride_ + w + 1].assign(grid_[row * stride_ + 1]);
+  }
 }
 
-std::size_t GridSimulation::left(std::size_t col) const {
-  return (col + parameters_.width - 1) % parameters_.width;
+// Ogni scrittura di una casella interna passa da qui: una sola divisione, e
+// solo per le caselle sul bordo. Con width o height pari a 1 la stessa
+// casella e' sia la prima che l'ultima, per cui i due casi non si escludono.
+// Gli angoli della cornice non servono: non sono vicini di nessuno.
+void GridSimulation::store(std::size_t i, Cell cell) {
+  grid_[i].assign(cell);
+  if (!grid_[i].edge()) return;
+
+  std::size_t const h{parameters_.height};
+  std::size_t const w{parameters_.width};
+  std::size_t const row{i / stride_};
+  std::size_t const col{i % stride_};
+  if (row == 1) grid_[(h + 1) * stride_ + col].assign(cell);
+  if (row == h) grid_[col].assign(cell);
+  if (col == 1) grid_[row * stride_ + w + 1].assign(cell);
+  if (col == w) grid_[row * stride_].assign(cell);
 }
 
-std::size_t GridSimulation::right(std::size_t col) const {
-  return (col + 1) % parameters_.width;
+std::size_t GridSimulation::canonical(std::size_t i) const {
+  if (!grid_[i].edge()) return i;
+
+  std::size_t const h{parameters_.height};
+  std::size_t const w{parameters_.width};
+  std::size_t row{i / stride_};
+  std::size_t col{i % stride_};
+  if (row == 0) {
+    row = h;
+  } else if (row == h + 1) {
+    row = 1;
+  }
+  if (col == 0) {
+    col = w;
+  } else if (col == w + 1) {
+    col = 1;
+  }
+  return row * stride_ + col;
 }
 
 // METODO REPRODUCE
 
 void GridSimulation::reproduce(std::size_t index,
-                               std::vector<std::size_t> const& free_neighb,
+                               Neighbours const& free_neighb,
                                std::size_t max) {
   if (free_neighb.empty()) {
     return;
   }
 
-  std::uniform_int_distribution<std::size_t> dist(0, free_neighb.size() - 1);
+  std::uniform_int_distribution<std::size_t> dist(0, free_neighb.size - 1);
   std::size_t child = free_neighb[dist(rng_)];
   // creato l'indice random della cella per il child, preso a caso nel free
   // neighbour
 
-  if (grid_[index].state == CellState::Prey) {
-    if (static_cast<std::size_t>(grid_[index].age) < max) {
+  if (grid_[index].state() == CellState::Prey) {
+    if (static_cast<std::size_t>(grid_[index].age()) < max) {
       return;
     }
-    grid_[child].state = CellState::Prey;
-    grid_[child].age = 0;
-    grid_[index].age = 0;
+    place(child, Cell::prey(0, true));
+    store(index, Cell::prey(0, true));
+    ++current_.fish;
 
     // pesce madre si splitta in due pesci figli, uno resta dove era pesce
     // madre, uno va in una cella random, entrambi a età zero
 
-  } else if (grid_[index].state == CellState::Predator) {
-    if (static_cast<std::size_t>(grid_[index].energy) < max) {
+  } else if (grid_[index].state() == CellState::Predator) {
+    if (static_cast<std::size_t>(grid_[index].energy()) < max) {
       return;
     }
     // l'energia del genitore viene divisa a meta' col figlio (come nel modello
     // Wa-Tor)
-    int const total_energy = grid_[index].energy;
-    grid_[index].energy = total_energy / 2;
-    grid_[child].energy = total_energy - grid_[index].energy;
-    grid_[child].state = CellState::Predator;
-    grid_[child].age = 0;
+    int const total_energy = grid_[index].energy();
+    store(index, Cell::predator(total_energy / 2, true));
+    place(child, Cell::predator(total_energy - total_energy / 2, true));
+    ++current_.sharks;
   }
 }
 
+// PLACE E VACATE
+// moved acceso vuol dire che la casella e' gia' in written_: vacate() lo
+// lascia com'e', per cui ogni casella ci entra una volta sola per passo
+
+void GridSimulation::place(std::size_t i, Cell cell) {
+  bool const listed{grid_[i].moved()};
+  store(i, cell);
+  if (!listed) written_.push_back(i);
+}
+
+void GridSimulation::vacate(std::size_t i) {
+  bool const listed{grid_[i].moved()};
+  store(i, Cell{});
+  if (listed) grid_[i].mark();
+}
+
 // metodo per creare il vicinato con uno stato generico
-std::vector<std::size_t> GridSimulation::neighbours(
-    std::size_t row, std::size_t col, CellState chosen_state) const {
-  std::vector<std::size_t> result;
-  std::array<std::array<std::size_t, 2>, 4> complete_neighb = {
-      {{up(row), col}, {row, right(col)}, {down(row), col}, {row, left(col)}}};
-
-  for (auto const& n : complete_neighb) {
-    if (grid_[index(n[0], n[1])].state == chosen_state) {
-      result.push_back(index(n[0], n[1]));
+GridSimulation::Neighbours GridSimulation::neighbours(
+    std::size_t i, CellState chosen_state) const {
+  Neighbours result;
+  std::array<std::size_t, 4> const complete_neighb = {
+      i - stride_, i + 1, i + stride_, i - 1};  // su, destra, giu', sinistra
+
+  for (std::size_t n : complete_neighb) {
+    if (grid_[n].state() == chosen_state) {
+      result.cells[result.size++] = canonical(n);
     }
   }
   return result;
@@ -138,183 +198,260 @@ std::vector<std::size_t> GridSimulation::neighbours(
 
 // PUBBLICI serve fare evolve e go
 
-// EVOLVE
+// ACT
+// muove l'individuo nella casella j, se c'e' e non si e' gia' mosso
 
-void GridSimulation::evolve() {
-  std::vector<std::size_t>
-      occupied;  // contiene gli indici delle caselle occupate ex (1,3,4)
-  for (std::size_t i = 0; i < grid_.size(); ++i) {
-    if (grid_[i].state != CellState::Empty) occupied.push_back(i);
-  }
-  std::shuffle(occupied.begin(), occupied.end(),
-               rng_);  // per questo serve algorithm
-  std::vector<bool> already_moved(grid_.size(), false);
-
-  for (std::size_t j : occupied) {
-    // forse controllo di cellstate empty è ridondante??
-    if (grid_[j].state == CellState::Empty || already_moved[j])
-      continue;  // se la cella è vuota ho ha subito un cambiamento, salta
-                 // l'iterazione
-
-    std::size_t const row{j / parameters_.width};
-    std::size_t const col{j % parameters_.width};  // FIN QUI UGUALE
-
-    if (grid_[j].state == CellState::Prey) {
-      // ---------------- CASO PREDA ----------------
-      std::vector<std::size_t> const safe_neighb =
-          neighbours(row, col, CellState::Empty);
-
-      if (safe_neighb.empty()) {
-        // nessuna cella libera: la preda resta ferma, ma invecchia comunque
-        grid_[j].age += 1;
-        already_moved[j] = true;
-      } else {
-        std::uniform_int_distribution<std::size_t> dist(0,
-                                                        safe_neighb.size() - 1);
-        std::size_t const chosen = safe_neighb[dist(rng_)];
-
-        grid_[chosen] = grid_[j];
-        grid_[chosen].age += 1;
-        grid_[j] = Cell{};
-
-        already_moved[chosen] = true;
-        already_moved[j] = true;
-
-        if (static_cast<std::size_t>(grid_[chosen].age) >=
-            static_cast<std::size_t>(parameters_.fish_breed_age)) {
-          std::size_t const breed_row{chosen / parameters_.width};
-          std::size_t const breed_col{chosen % parameters_.width};
-          reproduce(chosen, neighbours(breed_row, breed_col, CellState::Empty),
-                    static_cast<std::size_t>(parameters_.fish_breed_age));
-        }
-      }
+void GridSimulation::act(std::size_t j) {
+  if (grid_[j].state() == CellState::Empty || grid_[j].moved())
+    return;  // se la cella è vuota ho ha subito un cambiamento, salta
+             // l'iterazione
 
+  if (grid_[j].state() == CellState::Prey) {
+    // ---------------- CASO PREDA ----------------
+    Neighbours const safe_neighb = neighbours(j, CellState::Empty);
+
+    if (safe_neighb.empty()) {
+      // nessuna cella libera: la preda resta ferma, ma invecchia comunque
+      place(j, Cell::prey(std::min(grid_[j].age() + 1, age_limit_), true));
     } else {
-      // ---------------- CASO PREDATORE ----------------
-
-      std::vector<std::size_t> prey_neighb =
-          neighbours(row, col, CellState::Prey);
-      std::vector<std::size_t> empty_neighb =
-          neighbours(row, col, CellState::Empty);
-
-      std::size_t chosen{j};  // di default resta fermo
-
-      if (!prey_neighb.empty()) {
-        std::uniform_int_distribution<std::size_t> dist(0,
-                                                        prey_neighb.size() - 1);
-        chosen = prey_neighb[dist(rng_)];
-
-        grid_[chosen] = grid_[j];
-        grid_[chosen].energy -= parameters_.sharks_move_cost;
-        grid_[chosen].energy += parameters_.sharks_food_energy;
-        grid_[j] = Cell{};
-
-      } else if (!empty_neighb.empty()) {
-        std::uniform_int_distribution<std::size_t> dist(
-            0, empty_neighb.size() - 1);
-        chosen = empty_neighb[dist(rng_)];
-
-        grid_[chosen] = grid_[j];
-        grid_[chosen].energy -= parameters_.sharks_move_cost;
-        grid_[j] = Cell{};
-
-      } else {
-        // nessun vicino disponibile: resta fermo, ma paga comunque la metà del
-        // costo energetico
-        grid_[chosen].energy -= parameters_.sharks_move_cost / 2;
+      std::uniform_int_distribution<std::size_t> dist(0,
+                                                      safe_neighb.size - 1);
+      std::size_t const chosen = safe_neighb[dist(rng_)];
+
+      place(chosen,
+            Cell::prey(std::min(grid_[j].age() + 1, age_limit_), true));
+      vacate(j);
+
+      if (static_cast<std::size_t>(grid_[chosen].age()) >=
+          static_cast<std::size_t>(parameters_.fish_breed_age)) {
+        reproduce(chosen, neighbours(chosen, CellState::Empty),
+                  static_cast<std::size_t>(parameters_.fish_breed_age));
       }
+    }
 
-      already_moved[chosen] = true;
-      already_moved[j] = true;
+  } else {
+    // ---------------- CASO PREDATORE ----------------
 
-      if (grid_[chosen].energy <= 0) {
-        grid_[chosen] = Cell{};  // muore di fame
-      } else if (static_cast<std::size_t>(grid_[chosen].energy) >=
-                 static_cast<std::size_t>(parameters_.sharks_breed_energy)) {
-        std::size_t const breed_row{chosen / parameters_.width};
-        std::size_t const breed_col{chosen % parameters_.width};
-        reproduce(chosen, neighbours(breed_row, breed_col, CellState::Empty),
+    Neighbours const prey_neighb = neighbours(j, CellState::Prey);
+    Neighbours const empty_neighb = neighbours(j, CellState::Empty);
+
+    std::size_t chosen{j};  // di default resta fermo
+    // calcolata fuori dalla cella, dove non puo' essere negativa
+    int energy = grid_[j].energy();
+
+    if (!prey_neighb.empty()) {
+      std::uniform_int_distribution<std::size_t> dist(0,
+                                                      prey_neighb.size - 1);
+      chosen = prey_neighb[dist(rng_)];
+
+      energy -= parameters_.sharks_move_cost;
+      energy += parameters_.sharks_food_energy;
+      vacate(j);
+      --current_.fish;  // la preda viene mangiata
+
+    } else if (!empty_neighb.empty()) {
+      std::uniform_int_distribution<std::size_t> dist(
+          0, empty_neighb.size - 1);
+      chosen = empty_neighb[dist(rng_)];
+
+      energy -= parameters_.sharks_move_cost;
+      vacate(j);
+
+    } else {
+      // nessun vicino disponibile: resta fermo, ma paga comunque la metà del
+      // costo energetico
+      energy -= parameters_.sharks_move_cost / 2;
+    }
+
+    if (energy <= 0) {
+      vacate(chosen);  // muore di fame
+      --current_.sharks;
+    } else {
+      place(chosen, Cell::predator(energy, true));
+      if (static_cast<std::size_t>(energy) >=
+          static_cast<std::size_t>(parameters_.sharks_breed_energy)) {
+        reproduce(chosen, neighbours(chosen, CellState::Empty),
                   static_cast<std::size_t>(parameters_.sharks_breed_energy));
       }
     }
   }
-  history_.push_back(get_population());
 }
 
-// GO
+// EVOLVE
 
-void GridSimulation::go() {
-  while (history_.size() < parameters_.iterations) {
-    try {
-      this->evolve();
-    } catch (const std::runtime_error& error) {
-      std::cerr << error.what();
-      break;
+void GridSimulation::evolve() {
+  // contiene gli indici delle caselle occupate ex (1,3,4): le celle scritte
+  // nel passo precedente ancora occupate, in ordine rimescolato. Spegnere
+  // moved alle sole caselle di written_ basta a spegnerlo ovunque, senza
+  // scorrere la griglia.
+  occupied_.clear();
+  for (std::size_t i : written_) {
+    grid_[i].settle();
+    if (grid_[i].state() != CellState::Empty) occupied_.push_back(i);
+  }
+  written_.clear();
+  std::shuffle(occupied_.begin(), occupied_.end(),
+               rng_);  // per questo serve algorithm
+  for (std::size_t j : occupied_) act(j);
+#ifdef WATOR_DEBUG_COUNTERS
+  check_counters();
+#endif
+  ++steps_;
+  sink_->push(current_);
+}
+
+// CHECK_COUNTERS
+// Non alloca. Ogni individuo deve avere moved acceso e stare in written_,
+// dove ogni casella compare una volta sola: le caselle occupate della lista
+// sono tante quanti gli individui, e ogni casella con moved acceso e' nella
+// lista.
+void GridSimulation::check_counters() {
+  if (!(get_population() == current_)) {
+    throw std::logic_error("Population counters out of date.");
+  }
+  std::size_t listed{0};
+  std::size_t marked{0};
+  for (std::size_t i : written_) {
+    if (grid_[i].state() != CellState::Empty) ++listed;
+  }
+  bool all_moved{true};
+  for_each_index([&](std::size_t i) {
+    if (grid_[i].moved()) ++marked;
+    if (grid_[i].state() != CellState::Empty && !grid_[i].moved()) {
+      all_moved = false;
     }
+  });
+  if (!all_moved || listed != current_.fish + current_.sharks ||
+      marked != written_.size()) {
+    throw std::logic_error("Active list out of date.");
   }
+  // ogni vicino nella cornice deve avere lo stato della casella che copia
+  bool halo_ok{true};
+  for_each_index([&](std::size_t i) {
+    for (std::size_t n : {i - stride_, i + 1, i + stride_, i - 1}) {
+      if (grid_[n].state() != grid_[canonical(n)].state()) halo_ok = false;
+    }
+  });
+  if (!halo_ok) throw std::logic_error("Halo out of date.");
 }
 
-// SAVE_EVOLUTION()
-void GridSimulation::save_grid_evolution() {
-  std::ofstream outfile{"GRID_EVOLUTION.csv"};
-  outfile << "step\tfish\tsharks\n";
-  std::size_t step{0};
-  for (auto const& population : history_) {
-    outfile << step << '\t' << population.fish << '\t' << population.sharks
-            << '\n';
-    ++step;
+// EVOLVE_N
+// si ferma prima se la griglia si svuota: da li' in poi non cambia piu'
+
+volterra::Outcome GridSimulation::evolve_n(std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    if (current_.fish == 0 && current_.sharks == 0) {
+      return volterra::Outcome{volterra::Status::Extinct, steps_ - 1};
+    }
+    evolve();
   }
+  return volterra::Outcome{volterra::Status::Completed, steps_ - 1};
 }
 
-// SAVE_PLOT()
-void GridSimulation::save_grid_plot() {
-  std::ofstream data_file{".tmp_grid.csv"};
-  std::size_t step{0};
-
-  for (auto const& population : history_) {
-    data_file << step << '\t' << population.fish << '\t' << population.sharks
-              << '\n';
-    ++step;
+// GO
+
+void GridSimulation::go() {
+  if (steps_ < parameters_.iterations) {
+    evolve_n(parameters_.iterations - steps_);
   }
+  // griglia vuota: non cambia piu', la storia si completa senza evolvere
+  while (steps_ < parameters_.iterations) {
+    ++steps_;
+    sink_->push(current_);
+  }
+  sink_->flush();
+}
 
-  data_file.close();
-
-  std::ofstream gp_script{".tmp_grid.gp"};
-  gp_script
-      << "set terminal svg size 1000,600 font 'Arial,14' background '#99d6e1'\n"
-      << "set output 'GRID_PLOT.svg'\n"
-      << "set title 'WA-TOR POPULATION'\n"
-      << "set xlabel 'STEP'\n"
-      << "set ylabel 'INDIVIDUALS'\n"
-      << "set xrange [0:" << step - 1 << "]\n"
-      << "set autoscale y\n"
-      << "set grid\n"
-      << "plot '.tmp_grid.csv' using 1:2 with lines lw 2 lc rgb 'green' "
-         "title 'FISH', "
-      << "'.tmp_grid.csv' using 1:3 with lines lw 2 lc rgb 'blue' title "
-         "'SHARKS'\n";
-
-  gp_script.close();
-
-  int const check = std::system("gnuplot .tmp_grid.gp");
-  if (check != 0) {
-    std::cerr << "gnuplot failed\n";
+// HISTORY
+std::vector<Population> const& GridSimulation::history() const {
+  auto const* memory = volterra::memory_of(*sink_);
+  if (memory == nullptr) {
+    throw std::logic_error("The history is not kept in memory.");
   }
-  std::remove(".tmp_grid.gp");
-  std::remove(".tmp_grid.csv");
+  return memory->data();
+}
 
-  std::cout << "\nGrid plot and temporal evolution of the simulation saved.\n";
+// SET_SINK
+void GridSimulation::set_sink(
+    std::shared_ptr<volterra::Sink<Population>> sink) {
+  if (!sink) throw std::invalid_argument("Invalid input.");
+  sink_ = std::move(sink);
+  sink_->push(current_);
+}
+
+// SAVE_EVOLUTION()
+void GridSimulation::save_grid_evolution(std::string const& filename) {
+  volterra::write_text(filename, "step\tfish\tsharks", std::span{history()});
+}
+
+// SAVE_PLOT()
+void GridSimulation::save_grid_plot(std::string const& filename) {
+  auto const& populations = history();
+  auto step = [](std::size_t i) { return static_cast<double>(i); };
+  volterra::PlotStyle style{"WA-TOR POPULATION", "STEP", "INDIVIDUALS"};
+  volterra::save_svg(
+      filename, style,
+      {volterra::Series{"FISH", "#00ff00", populations.size(), step,
+                        [&](std::size_t i) {
+                          return static_cast<double>(populations[i].fish);
+                        }},
+       volterra::Series{"SHARKS", "#0000ff", populations.size(), step,
+                        [&](std::size_t i) {
+                          return static_cast<double>(populations[i].sharks);
+                        }}});
 }
 
 // EXTERNAL FUNCTIONS
-bool operator==(Cell const& a, Cell const& b) {
-  return a.state == b.state && a.energy == b.energy && a.age == b.age;
+void validate(GridParameters const& p) {
+  if (p.width == 0 || p.height == 0 || p.iterations == 0 ||
+      p.fish_density <= 0 || p.sharks_density <= 0 ||
+      (p.fish_density + p.sharks_density) > 1 || p.fish_density <= 0 ||
+      p.sharks_density <= 0 || p.sharks_initial_energy <= 0 ||
+      p.sharks_food_energy <= 0 || p.sharks_breed_energy <= 0 ||
+      p.sharks_move_cost <= 0) {
+    throw std::invalid_argument("Invalid input.");
+  }
+  // eta' ed energie devono entrare nel campo di 28 bit di Cell, compresa
+  // l'energia massima che un predatore raggiunge durante un passo (vedi
+  // Cell); calcolata in 64 bit, dove non trabocca
+  std::int64_t const gain{std::int64_t{p.sharks_food_energy} -
+                          p.sharks_move_cost};
+  std::int64_t const peak{std::max({std::int64_t{p.sharks_initial_energy},
+                                    std::int64_t{p.sharks_breed_energy} - 1,
+                                    gain}) +
+                          std::max(gain, std::int64_t{0})};
+  if (p.fish_breed_age > Cell::max_value || peak > Cell::max_value) {
+    throw std::invalid_argument("Invalid input.");
+  }
+  // (width + 2) * (height + 2) senza traboccare
+  if (p.width > max_cells || p.height > max_cells ||
+      (p.width + 2) > max_cells / (p.height + 2)) {
+    throw std::invalid_argument("Invalid input.");
+  }
 }
 
+bool operator==(Cell const& a, Cell const& b) { return a.bits() == b.bits(); }
+
 bool operator==(Population const& a, Population const& b) {
   return a.fish == b.fish && a.sharks == b.sharks;
 }
 
+void write_row(std::ostream& out, std::size_t step,
+               Population const& population) {
+  char line[volterra::TextWriter::max_row];
+  out.write(line, format_row(line, step, population) - line);
+}
+
+char* format_row(char* out, std::size_t step, Population const& population) {
+  out = volterra::to_text(out, step);
+  *out++ = '\t';
+  out = volterra::to_text(out, population.fish);
+  *out++ = '\t';
+  out = volterra::to_text(out, population.sharks);
+  *out++ = '\n';
+  return out;
+}
+
 bool operator==(GridParameters const& a, GridParameters const& b) {
   return a.width == b.width && a.height == b.height &&
          a.iterations == b.iterations && a.fish_density == b.fish_density &&
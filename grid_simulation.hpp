@@ -2,20 +2,76 @@
 #define GRID_SIMULATION_HPP
 
 #include <array>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "outcome.hpp"
+#include "sink.hpp"
+
 namespace wator {
 
 // ----------------------------------------------STRUCT-------------------------------------------------------------------
-enum class CellState { Empty, Prey, Predator };
+enum class CellState : std::uint32_t { Empty, Prey, Predator };
+
+// Cella compattata in 32 bit: lo stato nei 2 bit bassi, poi un bit acceso
+// quando la cella e' scritta durante un passo (moved), un bit che segna le
+// caselle sul bordo o nella cornice della griglia (edge, vedi
+// GridSimulation), nei 28 alti l'eta' (prede) o l'energia (predatori), che
+// non servono mai insieme.
+// L'eta' di una preda conta solo finche' non raggiunge fish_breed_age, per
+// cui la simulazione la ferma li'. Con g = food - move_cost, l'energia di
+// un predatore a inizio passo resta sotto max(initial, breed - 1, g): chi
+// arriva a breed si divide, e dopo aver mangiato c'e' sempre la casella
+// lasciata libera. Durante il passo, prima di dividersi, puo' arrivare a
+// quel valore piu' g. validate() rifiuta i parametri che non entrano nel
+// campo, prey() e predator() i valori fuori campo.
+class Cell {
+  std::uint32_t bits_{0};
+
+  static constexpr std::uint32_t state_bits{2};
+  static constexpr std::uint32_t state_mask{(1u << state_bits) - 1};
+  static constexpr std::uint32_t edge_bit{1u << (state_bits + 1)};
+  static constexpr std::uint32_t value_shift{state_bits + 2};
+
+  Cell(CellState state, int value, bool moved)
+      : bits_(static_cast<std::uint32_t>(value) << value_shift |
+              static_cast<std::uint32_t>(moved) << state_bits |
+              static_cast<std::uint32_t>(state)) {
+    if (value < 0 || value > max_value) {
+      throw std::invalid_argument("Invalid input.");
+    }
+  }
 
-struct Cell {
-  CellState state{CellState::Empty};
-  int energy{0};  // solo per i predatori
-  int age{0};     // per entrambi
+ public:
+  static constexpr int max_value{(1 << (32 - value_shift)) - 1};
+
+  Cell() = default;  // vuota
+  static Cell prey(int age, bool moved = false) {
+    return Cell{CellState::Prey, age, moved};
+  }
+  static Cell predator(int energy, bool moved = false) {
+    return Cell{CellState::Predator, energy, moved};
+  }
+
+  CellState state() const { return static_cast<CellState>(bits_ & state_mask); }
+  bool moved() const { return (bits_ >> state_bits & 1u) != 0; }
+  void settle() { bits_ &= ~(1u << state_bits); }  // spegne moved
+  void mark() { bits_ |= 1u << state_bits; }      // accende moved
+  // il bit di bordo appartiene alla casella, non all'individuo: assign()
+  // copia c lasciandolo com'e'
+  bool edge() const { return (bits_ & edge_bit) != 0; }
+  void set_edge() { bits_ |= edge_bit; }
+  void assign(Cell c) { bits_ = (c.bits_ & ~edge_bit) | (bits_ & edge_bit); }
+  int age() const { return static_cast<int>(bits_ >> value_shift); }
+  int energy() const { return static_cast<int>(bits_ >> value_shift); }
+  std::uint32_t bits() const { return bits_; }
 };
+static_assert(sizeof(Cell) == 4);
 
 struct Population {
   size_t fish{0};    // prey = fish
@@ -44,36 +100,92 @@ struct GridParameters {
 
 //----------------CLASSE-----------------------
 class GridSimulation {
+  // vicini di una cella con un certo stato: al massimo 4, tenuti sullo stack
+  // come indici di caselle interne
+  struct Neighbours {
+    std::array<std::size_t, 4> cells;
+    std::size_t size{0};
+
+    bool empty() const { return size == 0; }
+    std::size_t operator[](std::size_t i) const { return cells[i]; }
+  };
+
   // attributi
   GridParameters parameters_;
 
-  std::vector<Cell> grid_;  // griglia "appiattita" in un vettore 1D
-  std::vector<Population> history_;
+  // Griglia "appiattita" in un vettore 1D, con una cornice di una casella
+  // attorno: la riga 0 copia la riga height, la riga height + 1 copia la
+  // riga 1, e lo stesso per le colonne. Cosi' i vicini toroidali (effetto
+  // pacman) di una casella interna i sono i - stride_, i + 1, i + stride_,
+  // i - 1, senza modulo. Le caselle con edge acceso (le due righe e colonne
+  // esterne per lato) passano da store(), che aggiorna anche le copie.
+  std::vector<Cell> grid_;
+  std::size_t stride_;  // width + 2
+  int age_limit_;  // l'eta' delle prede si ferma a fish_breed_age
+  Population current_;  // aggiornata a ogni nascita e morte
+  std::size_t steps_{0};  // passi registrati, stato iniziale compreso
+  std::shared_ptr<volterra::Sink<Population>> sink_;
+  unsigned seed_;
   std::mt19937 rng_;
 
+  // Lista attiva: ogni cella scritta con un individuo durante il passo (o
+  // dal costruttore) finisce una volta sola in written_ (vedi place()), con
+  // moved acceso. All'inizio del passo successivo diventa occupied_,
+  // tenendo le celle ancora occupate e spegnendo il loro moved: ogni
+  // individuo vivo ci si trova, e nessun passo scorre l'intera griglia.
+  // Ciascuna delle due liste tiene fino a 8 byte per individuo: su una
+  // griglia piena contano piu' delle celle (4 byte ciascuna).
+  // Riusate a ogni passo: a regime un passo non alloca nulla.
+  std::vector<std::size_t> occupied_;
+  std::vector<std::size_t> written_;
+  // scrive un individuo (con moved acceso) nella casella interna i e la
+  // aggiunge a written_ se non c'e' gia'
+  void place(std::size_t i, Cell cell);
+  // svuota la casella interna i, lasciandola in written_ se c'era
+  void vacate(std::size_t i);
+  // muove l'individuo nella casella interna j, se non si e' gia' mosso
+  void act(std::size_t j);
+
+  // con WATOR_DEBUG_COUNTERS, a fine passo confronta contatori, lista
+  // attiva e cornice con un conteggio completo della griglia; lancia
+  // std::logic_error se differiscono
+  void check_counters();
+
   // ------------restituire la population x e y corrente)--------------
   Population get_population() const;
 
   // -----------index calculations-------------------------------------
+  // indice in grid_ della casella interna (row, col)
   std::size_t index(std::size_t row, std::size_t col) const;
-  Cell& current_cell(size_t row, size_t column);
-
-  // ------------------------------changing cells with pacman effect
+  // chiama f(i) per ogni casella interna, riga per riga
+  template <typename F>
+  void for_each_index(F f) const {
+    for (std::size_t row = 1; row <= parameters_.height; ++row) {
+      std::size_t const end{row * stride_ + parameters_.width + 1};
+      for (std::size_t i = row * stride_ + 1; i < end; ++i) f(i);
+    }
+  }
+
+  // ------------------------------cornice (effetto pacman)
   //  reminder: higher rows have lower indexes!
-  std::size_t up(std::size_t row) const;
-  std::size_t down(std::size_t row) const;
-  std::size_t left(std::size_t col) const;
-  std::size_t right(std::size_t col) const;
+  void refresh_halo();
+  // scrive cell nella casella interna i e, sul bordo, nelle sue copie
+  void store(std::size_t i, Cell cell);
+  // la casella interna di cui i e' una copia (i stessa se interna)
+  std::size_t canonical(std::size_t i) const;
 
-  void reproduce(std::size_t index, std::vector<std::size_t> const& free_neighb,
+  void reproduce(std::size_t index, Neighbours const& free_neighb,
                  std::size_t reproduction_treshold);
 
-  std::vector<std::size_t> neighbours(std::size_t row, std::size_t col,
-                                      CellState state) const;
+  Neighbours neighbours(std::size_t i, CellState state) const;
 
  public:
   // ----------------------------------------------------costruttore-----------------------------------------------------------
 
+  // Lo stesso seme da' sempre la stessa storia, ma non quella delle
+  // versioni che rimescolavano a ogni passo tutte le caselle occupate in
+  // ordine di griglia: la lista attiva le rimescola nell'ordine in cui sono
+  // state scritte, e con l'ordine di visita cambiano le storie di un seme.
   GridSimulation(GridParameters parameters, unsigned seed);
 
   // ------------------------------------------------getters----------------------------------------------------------------
@@ -81,21 +193,47 @@ class GridSimulation {
   size_t width() const { return parameters_.width; }
   size_t height() const { return parameters_.height; }
   size_t iterations() const { return parameters_.iterations; }
-  std::vector<Population> const& history() const { return history_; }
+  unsigned seed() const { return seed_; }
+  std::size_t steps() const { return steps_; }
+  Population const& current_population() const { return current_; }
+  std::vector<Population> const& history() const;
+
+  // destinazione delle popolazioni, di default tenute in memoria (history())
+  // il nuovo sink riceve prima la popolazione corrente, poi tutte le altre
+  void set_sink(std::shared_ptr<volterra::Sink<Population>> sink);
+  volterra::Sink<Population>& sink() const { return *sink_; }
 
   // ------------------------------------evolution----------------------------------------------------------------
   void evolve();
+  volterra::Outcome evolve_n(std::size_t count);
   void go();
-  void save_grid_evolution();
-  void save_grid_plot();
+  void save_grid_evolution(
+      std::string const& filename = "GRID_EVOLUTION.csv");
+  void save_grid_plot(std::string const& filename = "GRID_PLOT.svg");
 };
 
+// caselle al massimo di una griglia, cornice compresa: 2^36, 256 GiB di
+// celle, abbastanza per una griglia 100k x 100k
+constexpr std::size_t max_cells{std::size_t{1} << 36};
+
+// lancia std::invalid_argument se il costruttore rifiuterebbe i parametri,
+// anche quando eta' ed energie non entrerebbero in una Cell o la griglia
+// supera max_cells caselle
+void validate(GridParameters const& p);
+
 //----------------------- operatori di confronto--------------------------
 
 bool operator==(Cell const& a, Cell const& b);
 bool operator==(Population const& a, Population const& b);
 bool operator==(GridParameters const& a, GridParameters const& b);
 
+// una riga di GRID_EVOLUTION.csv, usata da save_grid_evolution() e da
+// FileSink<Population>
+void write_row(std::ostream& out, std::size_t step,
+               Population const& population);
+// la stessa riga scritta in out (vedi TextWriter), restituisce la fine
+char* format_row(char* out, std::size_t step, Population const& population);
+
 }  // namespace wator
 
 #endif
\ No newline at end of file
@@ -2,8 +2,36 @@
 
 #include "grid_simulation.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
 #include "doctest.h"
 
+// conta le allocazioni dell'intero programma di test, per verificare che
+// evolve() a regime non ne faccia
+namespace {
+std::atomic<std::size_t> allocations{0};
+}  // namespace
+
+// GCC scambia la coppia malloc/free per un new seguito da free()
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
 namespace {
 
 wator::GridParameters valid_parameters() {
@@ -82,11 +110,103 @@ TEST_CASE("Testing constructor validation") {
     CHECK_THROWS(wator::GridSimulation(bad, 1));
   }
 
+  SUBCASE("ages and energies that do not fit in a Cell") {
+    auto bad = p;
+    bad.fish_breed_age = wator::Cell::max_value + 1;
+    CHECK_THROWS(wator::GridSimulation(bad, 1));
+    bad = p;
+    bad.sharks_breed_energy = wator::Cell::max_value + 1;
+    CHECK_THROWS(wator::GridSimulation(bad, 1));
+    bad = p;
+    bad.sharks_food_energy = wator::Cell::max_value + 1;
+    CHECK_THROWS(wator::GridSimulation(bad, 1));
+    // ogni valore entra, ma un predatore che mangia ne esce
+    bad = p;
+    bad.sharks_initial_energy = wator::Cell::max_value;
+    bad.sharks_food_energy = 2;
+    bad.sharks_move_cost = 1;
+    CHECK_THROWS(wator::GridSimulation(bad, 1));
+    bad = p;
+    bad.sharks_breed_energy = wator::Cell::max_value;
+    CHECK_THROWS(wator::GridSimulation(bad, 1));
+  }
+
+  SUBCASE("grids with too many cells") {
+    auto bad = p;
+    bad.width = std::numeric_limits<std::size_t>::max();
+    CHECK_THROWS(wator::GridSimulation(bad, 1));
+    bad.width = std::size_t{1} << 32;
+    bad.height = std::size_t{1} << 32;  // il prodotto trabocca
+    CHECK_THROWS(wator::GridSimulation(bad, 1));
+    bad.width = 300000;
+    bad.height = 300000;
+    CHECK_THROWS(wator::validate(bad));
+    bad.width = 100000;
+    bad.height = 100000;
+    CHECK_NOTHROW(wator::validate(bad));
+  }
+
   SUBCASE("valid parameters do not throw") {
     CHECK_NOTHROW(wator::GridSimulation(p, 1));
+    auto large = p;
+    // food - move_cost = 17: l'energia arriva al massimo a breed - 1 + 17
+    large.sharks_breed_energy = wator::Cell::max_value - 16;
+    CHECK_NOTHROW(wator::GridSimulation(large, 1));
+    large.sharks_breed_energy = wator::Cell::max_value - 15;
+    CHECK_THROWS(wator::GridSimulation(large, 1));
   }
 }
 
+TEST_CASE("Testing Cell") {
+  // 4 byte per cella: le celle di una griglia 100k x 100k stanno in 40 GB,
+  // piu' fino a 8 byte per individuo in ciascuna delle due liste della
+  // simulazione (vedi GridSimulation), fino a 200 GB su una griglia piena
+  CHECK(sizeof(wator::Cell) == std::size_t(4));
+
+  wator::Cell const empty{};
+  CHECK(empty.state() == wator::CellState::Empty);
+
+  auto const fish = wator::Cell::prey(15);
+  CHECK(fish.state() == wator::CellState::Prey);
+  CHECK(fish.age() == 15);
+
+  auto const shark = wator::Cell::predator(wator::Cell::max_value);
+  CHECK(shark.state() == wator::CellState::Predator);
+  CHECK(shark.energy() == wator::Cell::max_value);
+
+  CHECK(wator::Cell::predator(15) == wator::Cell::predator(15));
+  CHECK_FALSE(wator::Cell::predator(15) == wator::Cell::prey(15));
+  CHECK_THROWS(wator::Cell::predator(wator::Cell::max_value + 1));
+  CHECK_THROWS(wator::Cell::prey(-1));
+
+  // il bit moved non tocca gli altri campi
+  CHECK_FALSE(empty.moved());
+  auto moved = wator::Cell::predator(wator::Cell::max_value, true);
+  CHECK(moved.moved());
+  CHECK(moved.state() == wator::CellState::Predator);
+  CHECK(moved.energy() == wator::Cell::max_value);
+  moved.settle();
+  CHECK_FALSE(moved.moved());
+  CHECK(moved == wator::Cell::predator(wator::Cell::max_value));
+  moved.mark();
+  CHECK(moved == wator::Cell::predator(wator::Cell::max_value, true));
+  CHECK(wator::Cell::prey(7, true).age() == 7);
+
+  // il bit di bordo resta alla casella quando ci si scrive un altro individuo
+  wator::Cell slot{};
+  slot.set_edge();
+  CHECK(slot.edge());
+  CHECK(slot.state() == wator::CellState::Empty);
+  slot.assign(wator::Cell::prey(wator::Cell::max_value, true));
+  CHECK(slot.edge());
+  CHECK(slot.moved());
+  CHECK(slot.age() == wator::Cell::max_value);
+  slot.assign(wator::Cell{});
+  CHECK(slot.edge());
+  CHECK(slot.state() == wator::CellState::Empty);
+  CHECK_FALSE(wator::Cell::predator(wator::Cell::max_value).edge());
+}
+
 TEST_CASE("Testing initialization") {
   auto p = valid_parameters();
   wator::GridSimulation sim(p, 42);
@@ -172,3 +292,149 @@ TEST_CASE("same seed gives same population history") {
     CHECK(sim1.history()[i] == sim2.history()[i]);
   }
 }
+
+// Storie fissate per il seme 42: cambiano solo se cambia l'ordine in cui
+// evolve() visita gli individui (vedi il costruttore di GridSimulation), e
+// vanno allora rigenerate.
+TEST_CASE("seed 42 gives the recorded population history") {
+  SUBCASE("dense grid") {
+    auto p = valid_parameters();
+    wator::GridSimulation sim(p, 42);
+    sim.go();
+    CHECK(sim.history()[1] == wator::Population{24, 18});
+    CHECK(sim.history()[3] == wator::Population{6, 36});
+    CHECK(sim.history()[10] == wator::Population{1, 3});
+    CHECK(sim.history()[19] == wator::Population{2, 0});
+  }
+
+  SUBCASE("sparse grid") {
+    auto p = valid_parameters();
+    p.width = 200;
+    p.height = 200;
+    p.fish_density = 0.01;
+    p.sharks_density = 0.005;
+    wator::GridSimulation sim(p, 42);
+    sim.go();
+    CHECK(sim.history()[1] == wator::Population{390, 220});
+    CHECK(sim.history()[3] == wator::Population{382, 228});
+    CHECK(sim.history()[10] == wator::Population{365, 17});
+    CHECK(sim.history()[19] == wator::Population{727, 3});
+  }
+}
+
+TEST_CASE("Testing sinks") {
+  auto p = valid_parameters();
+  p.iterations = 30;
+
+  wator::GridSimulation reference(p, 5);
+  reference.go();
+
+  SUBCASE("RingSink keeps only the last populations") {
+    wator::GridSimulation sim(p, 5);
+    auto ring = std::make_shared<volterra::RingSink<wator::Population>>(4);
+    sim.set_sink(ring);
+    sim.go();
+
+    CHECK(sim.steps() == p.iterations);
+    REQUIRE(ring->size() == std::size_t(4));
+    for (std::size_t i{0}; i < 4; ++i) {
+      CHECK((*ring)[i] == reference.history()[p.iterations - 4 + i]);
+    }
+    CHECK(sim.current_population() == reference.history().back());
+    CHECK_THROWS_AS(sim.history(), std::logic_error);
+  }
+
+  SUBCASE("CallbackSink receives every population") {
+    wator::GridSimulation sim(p, 5);
+    std::vector<wator::Population> received;
+    sim.set_sink(std::make_shared<volterra::CallbackSink<wator::Population>>(
+        [&received](wator::Population const& pop) {
+          received.push_back(pop);
+        }));
+    sim.go();
+
+    CHECK(received == reference.history());
+  }
+}
+
+TEST_CASE("Testing evolve_n()") {
+  // fish and sharks coexist for the whole run
+  wator::GridParameters const p{40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1};
+
+  wator::GridSimulation reference(p, 11);
+  reference.go();
+
+  wator::GridSimulation sim(p, 11);
+  auto const first = sim.evolve_n(10);
+  auto const second = sim.evolve_n(14);
+
+  CHECK(first.status == volterra::Status::Completed);
+  CHECK(first.step == std::size_t(10));
+  CHECK(second.step == std::size_t(24));
+  CHECK(sim.history() == reference.history());
+
+  SUBCASE("an empty grid stops the run") {
+    auto starving = valid_parameters();
+    starving.fish_density = 0.01;
+    starving.sharks_density = 0.5;
+    starving.sharks_initial_energy = 1;
+    starving.iterations = 100;
+    wator::GridSimulation dying(starving, 3);
+
+    auto const outcome = dying.evolve_n(99);
+    CHECK(outcome.status == volterra::Status::Extinct);
+    CHECK(outcome.step < std::size_t(99));
+    CHECK(dying.history().back() == wator::Population{0, 0});
+  }
+}
+
+TEST_CASE("Testing a sparse grid") {
+  // pochi individui: evolve() segue la lista attiva invece di scorrere la
+  // griglia, e con WATOR_DEBUG_COUNTERS ogni passo e' ricontato per intero
+  wator::GridParameters const p{200, 150, 40, 0.002, 0.0005, 8, 6, 10, 3, 1};
+  wator::GridSimulation sim(p, 17);
+  wator::GridSimulation same(p, 17);
+  sim.go();
+  same.go();
+
+  CHECK(sim.history() == same.history());
+  CHECK(sim.history().front().fish > std::size_t(0));
+  CHECK(sim.history().back().fish > sim.history().front().fish);
+  CHECK(sim.history().back().fish < std::size_t(30000 / 16));
+}
+
+TEST_CASE("Testing thin grids") {
+  // con una o due righe (o colonne) una casella e' vicina di se stessa o
+  // due volte dello stesso vicino: la cornice deve restare coerente, e con
+  // WATOR_DEBUG_COUNTERS ogni passo la ricontrolla
+  for (auto const [width, height] :
+       {std::array<std::size_t, 2>{1, 1}, {1, 40}, {40, 1}, {2, 2}, {2, 30},
+        {30, 2}, {3, 3}}) {
+    CAPTURE(width);
+    CAPTURE(height);
+    wator::GridParameters const p{width, height, 100, 0.5, 0.2, 3, 4, 5, 2, 1};
+    wator::GridSimulation sim(p, 5);
+    CHECK_NOTHROW(sim.go());
+    for (auto const& population : sim.history()) {
+      CHECK(population.fish + population.sharks <= width * height);
+    }
+  }
+}
+
+TEST_CASE("Testing evolve() does not allocate") {
+  // griglia piena all'inizio: la memoria di lavoro raggiunge subito la sua
+  // dimensione massima; RingSink non alloca dopo la costruzione
+  auto p = valid_parameters();
+  p.fish_density = 0.8;
+  p.sharks_density = 0.2;
+  wator::GridSimulation sim(p, 3);
+  sim.set_sink(std::make_shared<volterra::RingSink<wator::Population>>(1));
+  sim.evolve();
+
+  std::size_t const before = allocations;
+  for (int i = 0; i < 50; ++i) sim.evolve();
+  std::size_t const during = allocations - before;
+
+  CHECK(during == std::size_t(0));
+  CHECK(sim.steps() == std::size_t(52));
+}
@@ -0,0 +1,130 @@
+#include "integrators.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace volterra {
+
+namespace {
+
+// Dormand-Prince 5(4) tableau
+constexpr double a21{1. / 5.};
+constexpr double a31{3. / 40.}, a32{9. / 40.};
+constexpr double a41{44. / 45.}, a42{-56. / 15.}, a43{32. / 9.};
+constexpr double a51{19372. / 6561.}, a52{-25360. / 2187.},
+    a53{64448. / 6561.}, a54{-212. / 729.};
+constexpr double a61{9017. / 3168.}, a62{-355. / 33.}, a63{46732. / 5247.},
+    a64{49. / 176.}, a65{-5103. / 18656.};
+constexpr double b1{35. / 384.}, b3{500. / 1113.}, b4{125. / 192.},
+    b5{-2187. / 6784.}, b6{11. / 84.};
+// difference between the 5th and the embedded 4th order weights
+constexpr double e1{71. / 57600.}, e3{-71. / 16695.}, e4{71. / 1920.},
+    e5{-17253. / 339200.}, e6{22. / 525.}, e7{-1. / 40.};
+
+// PI controller (Gustafsson), exponents for an error of order 5
+constexpr double alpha{0.7 / 5.};
+constexpr double beta{0.4 / 5.};
+constexpr double safety{0.9};
+constexpr double min_factor{0.2};
+constexpr double max_factor{5.};
+
+}  // namespace
+
+// CONSTRUCTOR
+DormandPrince::DormandPrince(double tolerance) : tolerance_(tolerance) {
+  if (!(tolerance > 0)) throw std::invalid_argument("Invalid input.");
+}
+
+// STEP()
+double DormandPrince::step(double& x, double& y, double a, double d,
+                           double dt, double limit) {
+  auto fx = [a](double xx, double yy) { return a * xx * (1 - yy); };
+  auto fy = [d](double xx, double yy) { return d * yy * (xx - 1); };
+
+  if (h_ == 0.) h_ = dt;
+
+  bool const fsal = accepted_ != 0 && x == x_last_ && y == y_last_;
+  double const k1x = fsal ? kx_last_ : fx(x, y);
+  double const k1y = fsal ? ky_last_ : fy(x, y);
+
+  bool rejected_last{false};
+  while (true) {
+    // a shortened step does not shorten the following ones
+    bool const limited = limit < h_;
+    double const h = limited ? limit : h_;
+
+    double const k2x = fx(x + h * a21 * k1x, y + h * a21 * k1y);
+    double const k2y = fy(x + h * a21 * k1x, y + h * a21 * k1y);
+    double const x3 = x + h * (a31 * k1x + a32 * k2x);
+    double const y3 = y + h * (a31 * k1y + a32 * k2y);
+    double const k3x = fx(x3, y3);
+    double const k3y = fy(x3, y3);
+    double const x4 = x + h * (a41 * k1x + a42 * k2x + a43 * k3x);
+    double const y4 = y + h * (a41 * k1y + a42 * k2y + a43 * k3y);
+    double const k4x = fx(x4, y4);
+    double const k4y = fy(x4, y4);
+    double const x5 =
+        x + h * (a51 * k1x + a52 * k2x + a53 * k3x + a54 * k4x);
+    double const y5 =
+        y + h * (a51 * k1y + a52 * k2y + a53 * k3y + a54 * k4y);
+    double const k5x = fx(x5, y5);
+    double const k5y = fy(x5, y5);
+    double const x6 =
+        x + h * (a61 * k1x + a62 * k2x + a63 * k3x + a64 * k4x + a65 * k5x);
+    double const y6 =
+        y + h * (a61 * k1y + a62 * k2y + a63 * k3y + a64 * k4y + a65 * k5y);
+    double const k6x = fx(x6, y6);
+    double const k6y = fy(x6, y6);
+
+    double const x_new =
+        x + h * (b1 * k1x + b3 * k3x + b4 * k4x + b5 * k5x + b6 * k6x);
+    double const y_new =
+        y + h * (b1 * k1y + b3 * k3y + b4 * k4y + b5 * k5y + b6 * k6y);
+    double const k7x = fx(x_new, y_new);
+    double const k7y = fy(x_new, y_new);
+
+    double const err_x = h * (e1 * k1x + e3 * k3x + e4 * k4x + e5 * k5x +
+                              e6 * k6x + e7 * k7x);
+    double const err_y = h * (e1 * k1y + e3 * k3y + e4 * k4y + e5 * k5y +
+                              e6 * k6y + e7 * k7y);
+    double const scale_x =
+        tolerance_ * (1 + std::max(std::abs(x), std::abs(x_new)));
+    double const scale_y =
+        tolerance_ * (1 + std::max(std::abs(y), std::abs(y_new)));
+    double error = std::sqrt(((err_x / scale_x) * (err_x / scale_x) +
+                              (err_y / scale_y) * (err_y / scale_y)) /
+                             2);
+    if (!(x_new > 0) || !(y_new > 0) || !std::isfinite(error)) error = 1e10;
+
+    if (error <= 1.) {
+      double factor = safety * std::pow(std::max(error, 1e-10), -alpha) *
+                      std::pow(error_prev_, beta);
+      factor = std::clamp(factor, min_factor, max_factor);
+      if (rejected_last) factor = std::min(factor, 1.);
+
+      error_prev_ = std::max(error, 1e-4);
+      if (!limited) h_ = h * factor;
+      ++accepted_;
+
+      x = x_new;
+      y = y_new;
+      x_last_ = x;
+      y_last_ = y;
+      kx_last_ = k7x;
+      ky_last_ = k7y;
+      return h;
+    }
+
+    double const factor =
+        std::max(min_factor, safety * std::pow(error, -1. / 5.));
+    h_ = h * factor;
+    rejected_last = true;
+    ++rejected_;
+
+    // no acceptable step: leave x and y untouched and report no progress
+    if (h_ < std::numeric_limits<double>::epsilon() * dt) return 0.;
+  }
+}
+
+}  // namespace volterra
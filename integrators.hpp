@@ -0,0 +1,181 @@
+#ifndef INTEGRATORS_HPP
+#define INTEGRATORS_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace volterra {
+
+// ------------------------ INTEGRATORS ------------------------
+// Integration schemes usable as the policy of BasicSimulation. Each one
+// advances the relative coordinates x*c/d and y*b/a, where the model reads
+// x' = a x (1 - y), y' = d y (x - 1), by one step and returns the time
+// advanced: dt for the fixed-step schemes, the accepted step for the
+// adaptive one.
+//
+// Except for SymplecticEuler, the schemes split the Hamiltonian in its x and
+// y parts, whose flows are solved exactly (y *= exp(d (x - 1) h) with x
+// fixed, x *= exp(a (1 - y) h) with y fixed), so they are symplectic and
+// keep both populations positive.
+
+// first order, the historical update of Simulation::evolve()
+struct SymplecticEuler {
+  static constexpr int order{1};
+
+  double step(double& x, double& y, double a, double d, double dt) const {
+    y = y + d * (x - 1) * y * dt;
+    x = x + a * (1 - y) * x * dt;
+    return dt;
+  }
+};
+
+// second order: half y-flow, full x-flow, half y-flow
+struct StormerVerlet {
+  static constexpr int order{2};
+
+  double step(double& x, double& y, double a, double d, double dt) const {
+    y *= std::exp(d * (x - 1) * dt / 2);
+    x *= std::exp(a * (1 - y) * dt);
+    y *= std::exp(d * (x - 1) * dt / 2);
+    return dt;
+  }
+};
+
+// symmetric composition of Stormer-Verlet steps with the given weights
+template <std::size_t Stages>
+void compose(double& x, double& y, double a, double d, double dt,
+             std::array<double, Stages> const& weights) {
+  StormerVerlet const verlet{};
+  for (double const w : weights) verlet.step(x, y, a, d, w * dt);
+}
+
+// fourth order, Yoshida (1990) triple jump
+struct Yoshida4 {
+  static constexpr int order{4};
+  static constexpr double w1{1.3512071919596578};  // 1 / (2 - 2^(1/3))
+  static constexpr double w0{1 - 2 * w1};
+  static constexpr std::array<double, 3> weights{w1, w0, w1};
+
+  double step(double& x, double& y, double a, double d, double dt) const {
+    compose(x, y, a, d, dt, weights);
+    return dt;
+  }
+};
+
+// sixth order, Yoshida (1990) solution A, 7 stages
+struct Yoshida6 {
+  static constexpr int order{6};
+  static constexpr double w1{-1.17767998417887};
+  static constexpr double w2{0.235573213359357};
+  static constexpr double w3{0.784513610477560};
+  static constexpr double w0{1 - 2 * (w1 + w2 + w3)};
+  static constexpr std::array<double, 7> weights{w3, w2, w1, w0,
+                                                 w1, w2, w3};
+
+  double step(double& x, double& y, double a, double d, double dt) const {
+    compose(x, y, a, d, dt, weights);
+    return dt;
+  }
+};
+
+// eighth order, Yoshida (1990) solution D, 15 stages
+struct Yoshida8 {
+  static constexpr int order{8};
+  static constexpr double w1{0.102799849391985};
+  static constexpr double w2{-1.96061023297549};
+  static constexpr double w3{1.93813913762276};
+  static constexpr double w4{-0.158240635368243};
+  static constexpr double w5{-1.44485223686048};
+  static constexpr double w6{0.253693336566229};
+  static constexpr double w7{0.914844246229740};
+  static constexpr double w0{1 - 2 * (w1 + w2 + w3 + w4 + w5 + w6 + w7)};
+  static constexpr std::array<double, 15> weights{
+      w7, w6, w5, w4, w3, w2, w1, w0, w1, w2, w3, w4, w5, w6, w7};
+
+  double step(double& x, double& y, double a, double d, double dt) const {
+    compose(x, y, a, d, dt, weights);
+    return dt;
+  }
+};
+
+// Schemes advancing u = log x, v = log y instead of x and y. In these
+// coordinates the model is canonical with the separable Hamiltonian
+// H = d (e^u - u) + a (e^v - v), the populations stay positive whatever dt
+// and H needs no logarithm. BasicSimulation converts to and from them.
+template <typename Integrator>
+constexpr bool logarithmic_v = requires { requires Integrator::logarithmic; };
+
+// second order: half v-kick, full u-drift, half v-kick
+struct LogStormerVerlet {
+  static constexpr bool logarithmic{true};
+  static constexpr int order{2};
+
+  double step(double& u, double& v, double a, double d, double dt) const {
+    v += d * (std::exp(u) - 1) * dt / 2;
+    u += a * (1 - std::exp(v)) * dt;
+    v += d * (std::exp(u) - 1) * dt / 2;
+    return dt;
+  }
+};
+
+// the Yoshida compositions above, built on LogStormerVerlet
+template <typename Composition>
+struct LogComposition {
+  static constexpr bool logarithmic{true};
+  static constexpr int order{Composition::order};
+
+  double step(double& u, double& v, double a, double d, double dt) const {
+    LogStormerVerlet const verlet{};
+    for (double const w : Composition::weights) verlet.step(u, v, a, d, w * dt);
+    return dt;
+  }
+};
+
+using LogYoshida4 = LogComposition<Yoshida4>;
+using LogYoshida6 = LogComposition<Yoshida6>;
+using LogYoshida8 = LogComposition<Yoshida8>;
+
+// Dormand-Prince 5(4) with a PI step-size controller. The dt given to the
+// first step is only the initial guess; later steps are chosen so that the
+// local error stays below tolerance (mixed absolute/relative). Steps that
+// would make a population non-positive are rejected like inaccurate ones.
+// If the step shrinks below machine precision, step() returns 0.
+// Not symplectic: H drifts slowly, proportionally to the tolerance.
+class DormandPrince {
+ public:
+  static constexpr bool adaptive{true};
+
+ private:
+  double tolerance_;
+  double h_{0.};           // next step size, 0 until the first step
+  double error_prev_{1e-4};
+  std::size_t accepted_{0};
+  std::size_t rejected_{0};
+  // first-same-as-last: derivative at the end of the last accepted step
+  double x_last_{0.};
+  double y_last_{0.};
+  double kx_last_{0.};
+  double ky_last_{0.};
+
+ public:
+  explicit DormandPrince(double tolerance = 1e-8);
+
+  // no step is longer than limit
+  double step(double& x, double& y, double a, double d, double dt,
+              double limit = std::numeric_limits<double>::infinity());
+
+  double tolerance() const { return tolerance_; }
+  double next_step() const { return h_; }
+  std::size_t accepted() const { return accepted_; }
+  std::size_t rejected() const { return rejected_; }
+};
+
+// true for the schemes choosing their own step (DormandPrince)
+template <typename Integrator>
+constexpr bool adaptive_v = requires { requires Integrator::adaptive; };
+
+}  // namespace volterra
+
+#endif
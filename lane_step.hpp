@@ -0,0 +1,30 @@
+#ifndef LANE_STEP_HPP
+#define LANE_STEP_HPP
+
+#include "integrators.hpp"
+
+namespace volterra {
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// Internal to Ensemble and the stability map, which advance many runs per
+// loop. One step of Simulation::evolve() (SymplecticEuler) on the relative
+// coordinates of a run, without branches so that the loops can be
+// vectorized. A run whose step would go extinct, or that is already
+// extinct, stays frozen on its last valid state. Returns whether the run is
+// alive after the step.
+inline bool step_lane(double& x, double& y, double a, double d, double dt,
+                      bool alive) {
+  double x_new = x;
+  double y_new = y;
+  SymplecticEuler{}.step(x_new, y_new, a, d, dt);
+
+  bool const ok = (x_new > 0) & (y_new > 0) & alive;
+  x = ok ? x_new : x;
+  y = ok ? y_new : y;
+  return ok;
+}
+
+}  // namespace volterra
+
+#endif
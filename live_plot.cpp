@@ -0,0 +1,213 @@
+#include "live_plot.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+namespace volterra {
+
+namespace {
+
+// FOUND()
+// Whether the program of command exists, so that a missing gnuplot is
+// noticed before a shell is started for it.
+bool found(std::string const& command) {
+  std::string program;
+  std::istringstream{command} >> program;
+  if (program.empty()) return false;
+  if (program.find('/') != std::string::npos) {
+    return std::filesystem::exists(program);
+  }
+  char const* path = std::getenv("PATH");
+  std::istringstream directories{path == nullptr ? "" : path};
+  std::string directory;
+  while (std::getline(directories, directory, ':')) {
+    if (directory.empty()) continue;
+    std::error_code error;
+    if (std::filesystem::exists(std::filesystem::path{directory} / program,
+                                error)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// text between single quotes in a gnuplot command
+std::string gnuplot_text(std::string const& text) {
+  std::string result{"'"};
+  for (char c : text) {
+    if (c == '\'') result += '\'';  // '' is a quote inside '...'
+    result += c;
+  }
+  return result + "'";
+}
+
+}  // namespace
+
+//-------------------------CONSTRUCTORS-------------------------------
+
+LivePlot::LivePlot(
+    PlotStyle const& style,
+    std::vector<std::pair<std::string, std::string>> const& lines,
+    double interval, std::size_t capacity, std::string const& command)
+    : width_(lines.size() + 1),
+      last_(lines.size() + 1),
+      capacity_(capacity),
+      interval_(
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(interval))) {
+  if (lines.empty() || capacity < 2 || interval < 0) {
+    throw std::invalid_argument("Invalid input.");
+  }
+  for (auto const& [title, color] : lines) lines_.push_back({title, color});
+  points_.reserve(capacity_ * width_);
+  if (!found(command)) return;
+
+  pipe_ = ::popen(command.c_str(), "w");
+  if (pipe_ == nullptr) return;
+  for (int i{0}; i < 2; ++i) spare_.push(Frame{});
+  writer_ = std::thread{[this] { write(); }};
+
+  // same look as save_plot(), on the interactive terminal
+  char x_min[32];
+  std::snprintf(x_min, sizeof x_min, "%.17g", style.x_min);
+  Frame frame = spare_.pop();
+  frame.text = "set title " + gnuplot_text(style.title) + "\nset xlabel " +
+               gnuplot_text(style.x_label) + "\nset ylabel " +
+               gnuplot_text(style.y_label) +
+               "\nset grid\nset key top right\nset xrange [" + x_min +
+               ":*]\nset autoscale y\n"
+               "set object 1 rectangle from screen 0,0 to screen 1,1 behind "
+               "fillcolor rgb " +
+               gnuplot_text(style.background) + " fillstyle solid noborder\n";
+  frames_.push(std::move(frame));
+}
+
+LivePlot::~LivePlot() {
+  if (pipe_ == nullptr) return;
+  refresh();
+  frames_.push(Frame{Command::Stop, {}});
+  writer_.join();
+}
+
+//--------------------------PUBLIC FUNCTIONS-----------------------
+
+// REFRESH()
+void LivePlot::refresh() {
+  if (!active()) return;
+  send(true);
+}
+
+//--------------------------PRIVATE FUNCTIONS-----------------------
+
+// STORE()
+void LivePlot::store() {
+  if (stored() == capacity_) {
+    // keep every other point and store half as often from now on
+    std::size_t const n = stored();
+    for (std::size_t i{1}; 2 * i < n; ++i) {
+      std::copy_n(points_.data() + 2 * i * width_, width_,
+                  points_.data() + i * width_);
+    }
+    points_.resize((n + 1) / 2 * width_);
+    stride_ *= 2;
+  }
+  points_.insert(points_.end(), last_.begin(), last_.end());
+
+  auto const now = std::chrono::steady_clock::now();
+  if (now - drawn_ >= interval_) send(false);
+}
+
+// SEND()
+// One plot command with an inline binary data set per line; the last point
+// is sent even if it was not stored, so the window is never behind. Without
+// wait, nothing is sent while the writer still has both frames.
+void LivePlot::send(bool wait) {
+  Frame frame;
+  if (wait) {
+    frame = spare_.pop();
+  } else if (!spare_.try_pop(frame)) {
+    return;
+  }
+  drawn_ = std::chrono::steady_clock::now();
+  bool const extra = points_.empty() ||
+                     !std::equal(last_.begin(), last_.end(),
+                                 points_.end() -
+                                     static_cast<std::ptrdiff_t>(width_));
+  std::size_t const records = stored() + (extra ? 1 : 0);
+
+  std::string format;
+  for (std::size_t k{0}; k < width_; ++k) format += "%float64";
+  std::string& text = frame.text;
+  text = "plot ";
+  for (std::size_t k{0}; k < lines_.size(); ++k) {
+    text += (k == 0 ? "'-'" : ", ''");
+    text += " binary record=(" + std::to_string(records) + ") format='" +
+            format + "' using 1:" + std::to_string(k + 2) +
+            " with lines lw 2 lc rgb " + gnuplot_text(lines_[k].color) +
+            " title " + gnuplot_text(lines_[k].title);
+  }
+  text += '\n';
+
+  for (std::size_t k{0}; k < lines_.size(); ++k) {
+    text.append(reinterpret_cast<char const*>(points_.data()),
+                points_.size() * sizeof(double));
+    if (extra) {
+      text.append(reinterpret_cast<char const*>(last_.data()),
+                  width_ * sizeof(double));
+    }
+  }
+  frames_.push(std::move(frame));
+}
+
+// WRITE()
+// Runs on writer_. SIGPIPE is blocked here, so a closed window only makes
+// the write fail (the signal stays pending on this thread until it ends);
+// the pipe is closed here too, since closing flushes it.
+void LivePlot::write() {
+  sigset_t pipe_signal;
+  sigemptyset(&pipe_signal);
+  sigaddset(&pipe_signal, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &pipe_signal, nullptr);
+
+  while (true) {
+    Frame frame = frames_.pop();
+    if (frame.command == Command::Stop) break;
+    if (!broken_.load(std::memory_order_relaxed)) {
+      bool const ok = std::fwrite(frame.text.data(), 1, frame.text.size(),
+                                  pipe_) == frame.text.size() &&
+                      std::fflush(pipe_) == 0;
+      if (!ok) broken_.store(true, std::memory_order_relaxed);
+    }
+    spare_.push(std::move(frame));
+  }
+  ::pclose(pipe_);
+}
+
+//--------------------------FUNCTIONS-----------------------
+
+// LIVE_PLOT()
+std::shared_ptr<LivePlotSink<State>> live_plot(std::string const& command) {
+  PlotStyle const style{"POPULATION", "TIME", "INDIVIDUALS"};
+  return std::make_shared<LivePlotSink<State>>(std::make_unique<LivePlot>(
+      style,
+      std::vector<std::pair<std::string, std::string>>{
+          {"PREY", "#00ff00"}, {"PREDATORS", "#ffa500"}},
+      0.25, 4096, command));
+}
+
+// LIVE_GRID_PLOT()
+std::shared_ptr<LivePlotSink<wator::Population>> live_grid_plot(
+    std::string const& command) {
+  PlotStyle const style{"WA-TOR POPULATION", "STEP", "INDIVIDUALS"};
+  return std::make_shared<LivePlotSink<wator::Population>>(
+      std::make_unique<LivePlot>(
+          style,
+          std::vector<std::pair<std::string, std::string>>{
+              {"FISH", "#00ff00"}, {"SHARKS", "#0000ff"}},
+          0.25, 4096, command));
+}
+
+}  // namespace volterra
@@ -0,0 +1,158 @@
+#ifndef LIVE_PLOT_HPP
+#define LIVE_PLOT_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "grid_simulation.hpp"
+#include "simulation.hpp"
+#include "sink.hpp"
+#include "spsc_queue.hpp"
+#include "svg_plot.hpp"
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// A gnuplot window updated while a run goes on. One gnuplot process is
+// kept open through a pipe for the whole run and receives the points as
+// binary float64 records, no temporary file is written.
+// To keep the cost per point to a counter increment, only one point every
+// stride() is stored, and when capacity points are stored every other one
+// is dropped and the stride doubles; the window is redrawn at most once
+// per interval. If the command cannot be found or the pipe breaks, the plot
+// becomes inactive and every call does nothing.
+// The pipe is written by a background thread, which blocks SIGPIPE for
+// itself only. A redraw that finds both frames still queued is skipped, so
+// a slow gnuplot never stalls the run; refresh() and the destructor wait.
+class LivePlot {
+  struct Line {
+    std::string title;
+    std::string color;
+  };
+  enum class Command { Write, Stop };
+  struct Frame {
+    Command command{Command::Write};
+    std::string text;  // commands and binary data, as sent to the pipe
+  };
+
+  std::FILE* pipe_{nullptr};
+  std::atomic<bool> broken_{false};
+  SpscQueue<Frame> frames_{3};  // plot -> writer, + Stop
+  SpscQueue<Frame> spare_{2};   // writer -> plot
+  std::thread writer_;
+  std::vector<Line> lines_;
+  std::size_t width_;  // values per point: x and one y per line
+  std::vector<double> points_;
+  std::vector<double> last_;  // most recent point, stored or not
+  std::size_t capacity_;
+  std::size_t stride_{1};
+  std::size_t skipped_{0};
+  std::chrono::steady_clock::duration interval_;
+  std::chrono::steady_clock::time_point drawn_{};
+
+  void write();
+  void send(bool wait);
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  // lines: title and color of every y, as in Series
+  LivePlot(PlotStyle const& style,
+           std::vector<std::pair<std::string, std::string>> const& lines,
+           double interval = 0.25, std::size_t capacity = 4096,
+           std::string const& command = "gnuplot -persist");
+  LivePlot(LivePlot const&) = delete;
+  LivePlot& operator=(LivePlot const&) = delete;
+  // draws the last point and leaves the window to gnuplot
+  ~LivePlot();
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  bool active() const {
+    return pipe_ != nullptr && !broken_.load(std::memory_order_relaxed);
+  }
+  std::size_t stride() const { return stride_; }
+  std::size_t stored() const { return points_.size() / width_; }
+
+  // ys.size() must be the number of lines
+  void add(double x, std::span<double const> ys) {
+    if (!active()) return;
+    last_[0] = x;
+    std::copy(ys.begin(), ys.end(), last_.begin() + 1);
+    if (++skipped_ < stride_) return;
+    skipped_ = 0;
+    store();
+  }
+  // redraws now, with every point added so far
+  void refresh();
+
+ private:
+  void store();
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// x and the ys of one value: t, prey, predators or step, fish, sharks
+inline std::array<double, 3> plot_point(std::size_t, State const& state) {
+  return {state.t, state.x, state.y};
+}
+inline std::array<double, 3> plot_point(std::size_t step,
+                                        wator::Population const& p) {
+  return {static_cast<double>(step), static_cast<double>(p.fish),
+          static_cast<double>(p.sharks)};
+}
+
+// --------------------------- CLASS ---------------------------
+
+// Sink drawing a LivePlot while passing every value on to another sink
+// (by default a VectorSink, so evolution() and history() keep working).
+template <typename T>
+class LivePlotSink : public Sink<T> {
+  std::shared_ptr<Sink<T>> target_;
+  std::unique_ptr<LivePlot> plot_;
+  std::size_t rows_{0};
+
+ public:
+  LivePlotSink(std::unique_ptr<LivePlot> plot,
+               std::shared_ptr<Sink<T>> target =
+                   std::make_shared<VectorSink<T>>())
+      : target_(std::move(target)), plot_(std::move(plot)) {
+    if (!target_ || !plot_) throw std::invalid_argument("Invalid input.");
+  }
+
+  void push(T const& value) override {
+    target_->push(value);
+    auto const point = plot_point(rows_++, value);
+    plot_->add(point[0], std::span{point}.subspan(1));
+  }
+  void flush() override {
+    target_->flush();
+    plot_->refresh();
+  }
+  void stamp_time() override { target_->stamp_time(); }
+  Sink<T> const* forwards_to() const override { return target_.get(); }
+
+  LivePlot const& plot() const { return *plot_; }
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// the live versions of save_plot() and save_grid_plot()
+std::shared_ptr<LivePlotSink<State>> live_plot(
+    std::string const& command = "gnuplot -persist");
+std::shared_ptr<LivePlotSink<wator::Population>> live_grid_plot(
+    std::string const& command = "gnuplot -persist");
+
+}  // namespace volterra
+
+#endif
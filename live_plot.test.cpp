@@ -0,0 +1,109 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "live_plot.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+
+#include "doctest.h"
+#include "test_files.hpp"
+
+TEST_CASE("Testing LivePlot without gnuplot") {
+  CHECK_THROWS(volterra::LivePlot({}, {}));
+  CHECK_THROWS(volterra::LivePlot({}, {{"A", "red"}}, 0.1, 1));
+
+  auto sink = volterra::live_plot("no-such-program-for-volterra");
+  CHECK_FALSE(sink->plot().active());
+
+  // the run and its evolution are unaffected
+  volterra::Simulation sim({1., 0.5, 0.2, 0.8}, 3., 2., 0.001, 1000.);
+  sim.set_sink(sink);
+  sim.go();
+  CHECK(sim.evolution().size() == 1000);
+  CHECK(sink->plot().stored() == 0);
+}
+
+TEST_CASE("Testing the data sent to gnuplot") {
+  // a stand-in for gnuplot that keeps what it receives
+  std::string const captured = temporary("volterra_live_plot.out");
+  std::remove(captured.c_str());
+  {
+    auto sink = volterra::live_grid_plot("cat > '" + captured + "'");
+    REQUIRE(sink->plot().active());
+    wator::GridSimulation grid({40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1}, 11);
+    grid.set_sink(sink);
+    grid.go();
+    CHECK(grid.history().size() == 25);
+  }
+  std::string const output = read_file(captured);
+  CHECK(output.find("set title 'WA-TOR POPULATION'") != std::string::npos);
+  CHECK(output.find("fillcolor rgb '#99d6e1'") != std::string::npos);
+
+  // the last command draws all 25 steps: two lines of 25 records of 3
+  // doubles, the last record being step 24
+  std::string const command =
+      "plot '-' binary record=(25) format='%float64%float64%float64' "
+      "using 1:2 with lines lw 2 lc rgb '#00ff00' title 'FISH', '' binary "
+      "record=(25) format='%float64%float64%float64' using 1:3 with lines "
+      "lw 2 lc rgb '#0000ff' title 'SHARKS'\n";
+  auto const last = output.rfind(command);
+  REQUIRE(last != std::string::npos);
+  REQUIRE(output.size() == last + command.size() + 2 * 25 * 3 * 8);
+  double step{};
+  std::copy_n(output.data() + last + command.size() + 24 * 3 * 8,
+              sizeof(double), reinterpret_cast<char*>(&step));
+  CHECK(step == 24.);
+  std::remove(captured.c_str());
+}
+
+TEST_CASE("Testing LivePlot decimation") {
+  std::string const captured = temporary("volterra_live_decimation.out");
+  volterra::LivePlot plot({}, {{"A", "red"}}, 1e9, 64,
+                          "cat > '" + captured + "'");
+  REQUIRE(plot.active());
+  for (int i = 0; i < 100000; ++i) {
+    double const y = i;
+    plot.add(i, std::span{&y, 1});
+    CHECK(plot.stored() <= 64);
+  }
+  CHECK(plot.stride() >= 100000 / 64);
+  CHECK(plot.stored() >= 32);
+  std::remove(captured.c_str());
+}
+
+TEST_CASE("Testing LivePlot with a closed window") {
+  struct sigaction before {};
+  sigaction(SIGPIPE, nullptr, &before);
+  {
+    // the reader goes away at once: writing fails, the run goes on
+    volterra::LivePlot plot({}, {{"A", "red"}}, 0., 64, "true");
+    REQUIRE(plot.active());
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; plot.active(); ++i) {
+      double const y = i;
+      plot.add(i, std::span{&y, 1});
+      plot.refresh();
+      REQUIRE(std::chrono::steady_clock::now() - start <
+              std::chrono::seconds(10));
+    }
+  }
+  // the handling of SIGPIPE in the rest of the program is untouched
+  struct sigaction after {};
+  sigaction(SIGPIPE, nullptr, &after);
+  CHECK(after.sa_handler == before.sa_handler);
+}
+
+TEST_CASE("Testing LivePlot with a slow gnuplot") {
+  // the reader starts after a second: the points are still taken at once
+  volterra::LivePlot plot({}, {{"A", "red"}}, 0., 4096,
+                          "sleep 1; cat > /dev/null");
+  REQUIRE(plot.active());
+  auto const start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 20000; ++i) {
+    double const y = i;
+    plot.add(i, std::span{&y, 1});
+  }
+  CHECK(std::chrono::steady_clock::now() - start <
+        std::chrono::milliseconds(500));
+}
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <string>
 
+#include "batch.hpp"
 #include "grid_simulation.hpp"
+#include "live_plot.hpp"
+#include "phase_portrait.hpp"
 #include "simulation.hpp"
 
 namespace {
@@ -13,7 +19,39 @@ T control_as(std::string const& message) {
   return static_cast<T>(v);
 }
 
-void run_continuous_simulation() {
+// the live plot shows the run while it goes on, if gnuplot can be started
+template <typename Sink>
+void watch(Sink const& sink) {
+  if (!sink->plot().active()) {
+    std::cerr << "gnuplot not found, no live plot.\n";
+  }
+}
+
+// orbits of H levels from the equilibrium out to the one of the run
+void save_portrait(volterra::Simulation const& sim) {
+  volterra::Parameters const& p = sim.parameters();
+  double const H_min =
+      p.d - p.d * std::log(p.d / p.c) + p.a - p.a * std::log(p.a / p.b);
+  double const H_run = sim.initial_state().H;
+  if (!(H_run > H_min)) return;
+
+  std::vector<double> levels;
+  for (int i{1}; i <= 12; ++i) {
+    levels.push_back(H_min + (H_run - H_min) * i / 12.);
+  }
+  auto const steps =
+      static_cast<std::size_t>(std::min(sim.iterations(), 1e6));
+  volterra::ThreadPool pool;
+  auto const orbits = volterra::integrate_orbits(
+      p, volterra::level_starts(p, levels), sim.timescale(), steps,
+      std::max<std::size_t>(1, steps / 2000), pool);
+  auto const box = volterra::enclosing(orbits);
+  volterra::save_phase_portrait("PHASE_PORTRAIT.svg", box, orbits,
+                                volterra::vector_field(p, box, 20, 15));
+  std::cout << "Phase portrait saved.\n";
+}
+
+void run_continuous_simulation(bool live, bool phase) {
   volterra::Parameters p;
   p.a = volterra::control("Enter prey birth rate: ");
   p.b = volterra::control("Enter prey death rate: ");
@@ -26,13 +64,21 @@ void run_continuous_simulation() {
   double const it = volterra::control("Enter number of iterations: ");
 
   volterra::Simulation sim(p, x, y, dt, it);
+  if (live) {
+    auto const sink = volterra::live_plot();
+    watch(sink);
+    sim.set_sink(sink);
+  }
 
   sim.go();
   sim.save_evolution();
   sim.save_plot();
+  std::cout << "\nPlot and temporal evolution of the simulation saved.\n";
+
+  if (phase) save_portrait(sim);
 }
 
-void run_grid_simulation() {
+void run_grid_simulation(bool live) {
   wator::GridParameters p;
   p.width = control_as<std::size_t>("Enter grid width: ");
   p.height = control_as<std::size_t>("Enter grid height: ");
@@ -53,10 +99,16 @@ void run_grid_simulation() {
   unsigned const seed = control_as<unsigned>("Enter random seed: ");
 
   wator::GridSimulation sim(p, seed);
+  if (live) {
+    auto const sink = volterra::live_grid_plot();
+    watch(sink);
+    sim.set_sink(sink);
+  }
   sim.go();
 
   sim.save_grid_evolution();
   sim.save_grid_plot();
+  std::cout << "\nGrid plot and temporal evolution of the simulation saved.\n";
 
   auto const& last = sim.history().back();
   std::cout << "\nSimulazione conclusa dopo " << sim.history().size()
@@ -64,10 +116,65 @@ void run_grid_simulation() {
             << last.sharks << " predatori.\n";
 }
 
+// headless mode: every job of the manifest, in parallel
+int run_batch(std::string const& manifest, bool plot) {
+  std::ifstream in{manifest};
+  if (!in) throw std::invalid_argument("Cannot open " + manifest + ".");
+  auto const jobs = volterra::read_manifest(in);
+
+  volterra::ThreadPool pool;
+  auto const results = volterra::run_jobs(jobs, pool, plot);
+
+  int failed{0};
+  for (std::size_t i{0}; i < jobs.size(); ++i) {
+    auto const& result = results[i];
+    if (!result.valid) {
+      std::cerr << jobs[i].name << ": " << result.error << '\n';
+      ++failed;
+    } else if (result.outcome.status != volterra::Status::Completed) {
+      std::cout << jobs[i].name << ": stopped after "
+                << result.outcome.step + 1 << " states"
+                << volterra::message(result.outcome.status);
+    }
+  }
+  std::cout << jobs.size() - static_cast<std::size_t>(failed) << " of "
+            << jobs.size() << " jobs saved.\n";
+  return failed == 0 ? 0 : 1;
+}
+
 }  // namespace
 
-int main() {
+// Without arguments the program asks for one simulation on stdin ("main
+// --live" also shows it in a gnuplot window while it runs, "main --phase"
+// also saves the phase portrait of a continuous run); with
+// "main <manifest> [--no-plot]" it runs every job of the manifest instead
+// (see volterra::read_manifest() for the format).
+int main(int argc, char* argv[]) {
   try {
+    std::string const usage{
+        "Usage: main [--live] [--phase] or main manifest [--no-plot]"};
+    std::string const first = argc > 1 ? argv[1] : "";
+    if (argc > 1 && first.rfind("--", 0) != 0) {
+      std::string const option = argc > 2 ? argv[2] : "";
+      if (argc > 3 || (argc == 3 && option != "--no-plot")) {
+        throw std::invalid_argument(usage);
+      }
+      return run_batch(argv[1], argc == 2);
+    }
+
+    bool live{false};
+    bool phase{false};
+    for (int i{1}; i < argc; ++i) {
+      std::string const option{argv[i]};
+      if (option == "--live") {
+        live = true;
+      } else if (option == "--phase") {
+        phase = true;
+      } else {
+        throw std::invalid_argument(usage);
+      }
+    }
+
     std::cout << "Quale simulazione vuoi eseguire?\n"
               << "  1) Modello continuo (equazioni di Lotka-Volterra)\n"
               << "  2) Modello a griglia (Wa-Tor)\n"
@@ -77,9 +184,9 @@ int main() {
     if (std::cin.fail()) throw std::invalid_argument("Invalid input.");
 
     if (choice == 1) {
-      run_continuous_simulation();
+      run_continuous_simulation(live, phase);
     } else if (choice == 2) {
-      run_grid_simulation();
+      run_grid_simulation(live);
     } else {
       throw std::invalid_argument("Invalid choice.");
     }
@@ -0,0 +1,73 @@
+#include "orbit_analyzer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace volterra {
+
+//-------------------------CONSTRUCTORS-------------------------------
+
+OrbitAnalyzer::OrbitAnalyzer(Parameters const& p) : section_(p.d / p.c) {
+  if (p.a <= 0 || p.b <= 0 || p.c <= 0 || p.d <= 0)
+    throw std::invalid_argument("Invalid input.");
+}
+
+//--------------------------PUBLIC FUNCTIONS-----------------------
+
+// OBSERVE()
+void OrbitAnalyzer::observe(State const& state) {
+  if (!started_) {
+    started_ = true;
+    min_x_ = max_x_ = state.x;
+    min_y_ = max_y_ = state.y;
+    H_0_ = state.H;
+  } else if (previous_.x < section_ && state.x >= section_) {
+    // upward crossing of the section between previous_ and state
+    double const fraction = (section_ - previous_.x) / (state.x - previous_.x);
+    double const crossing = previous_.t + fraction * (state.t - previous_.t);
+
+    if (crossings_ != 0) {
+      last_period_ = crossing - last_crossing_;
+      std::size_t const n = crossings_;  // periods including this one
+      double const delta = last_period_ - period_mean_;
+      period_mean_ += delta / static_cast<double>(n);
+      period_m2_ += delta * (last_period_ - period_mean_);
+    }
+    last_crossing_ = crossing;
+    ++crossings_;
+  }
+
+  min_x_ = std::min(min_x_, state.x);
+  max_x_ = std::max(max_x_, state.x);
+  min_y_ = std::min(min_y_, state.y);
+  max_y_ = std::max(max_y_, state.y);
+
+  double const drift = state.H - H_0_;
+  drift_min_ = std::min(drift_min_, drift);
+  drift_max_ = std::max(drift_max_, drift);
+  drift_sum_ += drift;
+
+  previous_ = state;
+  ++observed_;
+}
+
+// PERIOD_STDDEV()
+double OrbitAnalyzer::period_stddev() const {
+  std::size_t const n = periods();
+  return n < 2 ? 0. : std::sqrt(period_m2_ / static_cast<double>(n - 1));
+}
+
+// PHASE()
+double OrbitAnalyzer::phase() const {
+  if (periods() == 0) return 0.;
+  double const elapsed = previous_.t - last_crossing_;
+  return std::fmod(elapsed / last_period_, 1.);
+}
+
+// DRIFT_MEAN()
+double OrbitAnalyzer::drift_mean() const {
+  return observed_ == 0 ? 0. : drift_sum_ / static_cast<double>(observed_);
+}
+
+}  // namespace volterra
@@ -0,0 +1,76 @@
+#ifndef ORBIT_ANALYZER_HPP
+#define ORBIT_ANALYZER_HPP
+
+#include <cstddef>
+
+#include "simulation.hpp"
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// Period, extrema and Hamiltonian drift of a continuous run, computed while
+// the run goes on with O(1) memory (attach it with set_analyzer()).
+// The Poincare section is x = d/c crossed with x increasing, i.e. in the
+// half-plane y < a/b: there y is at its minimum, so the crossing is clean.
+// Crossing times are linearly interpolated between consecutive steps.
+class OrbitAnalyzer {
+  double section_;  // d/c
+  bool started_{false};
+  State previous_{};
+
+  // section crossings and periods (Welford mean/variance)
+  std::size_t crossings_{0};
+  double last_crossing_{0.};
+  double last_period_{0.};
+  double period_mean_{0.};
+  double period_m2_{0.};
+
+  // running extrema
+  double min_x_{0.};
+  double max_x_{0.};
+  double min_y_{0.};
+  double max_y_{0.};
+
+  // Hamiltonian drift with respect to the first observed state
+  double H_0_{0.};
+  double drift_min_{0.};
+  double drift_max_{0.};
+  double drift_sum_{0.};
+  std::size_t observed_{0};
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  explicit OrbitAnalyzer(Parameters const& p);
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  void observe(State const& state);
+
+  // getters
+  std::size_t observed() const { return observed_; }
+  std::size_t crossings() const { return crossings_; }
+  std::size_t periods() const { return crossings_ == 0 ? 0 : crossings_ - 1; }
+  double last_crossing() const { return last_crossing_; }
+  double last_period() const { return last_period_; }
+  double period() const { return period_mean_; }
+  double period_stddev() const;
+  // fraction of the last period elapsed since the last crossing
+  double phase() const;
+
+  double min_x() const { return min_x_; }
+  double max_x() const { return max_x_; }
+  double min_y() const { return min_y_; }
+  double max_y() const { return max_y_; }
+  double amplitude_x() const { return (max_x_ - min_x_) / 2; }
+  double amplitude_y() const { return (max_y_ - min_y_) / 2; }
+
+  double initial_H() const { return H_0_; }
+  double drift() const { return previous_.H - H_0_; }
+  double drift_min() const { return drift_min_; }
+  double drift_max() const { return drift_max_; }
+  double drift_mean() const;
+};
+
+}  // namespace volterra
+
+#endif
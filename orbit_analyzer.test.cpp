@@ -0,0 +1,76 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "orbit_analyzer.hpp"
+
+#include <numbers>
+
+#include "doctest.h"
+
+using LogSimulation = volterra::BasicSimulation<volterra::LogYoshida4>;
+
+TEST_CASE("Testing constructor") {
+  CHECK_THROWS(volterra::OrbitAnalyzer({0., 1., 1., 1.}));
+  CHECK_THROWS(volterra::OrbitAnalyzer({1., 1., -1., 1.}));
+  CHECK_NOTHROW(volterra::OrbitAnalyzer({1., 1., 1., 1.}));
+}
+
+TEST_CASE("Testing period near the equilibrium") {
+  // small oscillations have period 2 pi / sqrt(a d)
+  volterra::Parameters const p{2., 1., 1., 0.5};
+  LogSimulation sim(p, 0.501, 2., 0.01, 6000.);
+  auto analyzer = std::make_shared<volterra::OrbitAnalyzer>(p);
+  sim.set_sink(std::make_shared<volterra::RingSink<volterra::State>>(1));
+  sim.set_analyzer(analyzer);
+  sim.go();
+
+  CHECK(analyzer->observed() == std::size_t(6000));
+  REQUIRE(analyzer->periods() >= std::size_t(5));
+  CHECK(analyzer->period() ==
+        doctest::Approx(2 * std::numbers::pi).epsilon(1e-4));
+  CHECK(analyzer->last_period() ==
+        doctest::Approx(analyzer->period()).epsilon(1e-6));
+  CHECK(analyzer->period_stddev() < 1e-6);
+  CHECK(analyzer->phase() >= 0.);
+  CHECK(analyzer->phase() < 1.);
+}
+
+TEST_CASE("Testing extrema and drift against the stored trajectory") {
+  volterra::Parameters const p{1.3, 0.5, 0.2, 0.8};
+  volterra::Simulation sim(p, 10., 4., 0.001, 30000.);
+  auto analyzer = std::make_shared<volterra::OrbitAnalyzer>(p);
+  sim.set_analyzer(analyzer);
+  sim.go();
+
+  auto const& evolution = sim.evolution();
+  double min_x{evolution[0].x}, max_x{evolution[0].x};
+  double min_y{evolution[0].y}, max_y{evolution[0].y};
+  double min_drift{0.}, max_drift{0.}, sum_drift{0.};
+  std::size_t crossings{0};
+  for (std::size_t i{0}; i < evolution.size(); ++i) {
+    auto const& s = evolution[i];
+    min_x = std::min(min_x, s.x);
+    max_x = std::max(max_x, s.x);
+    min_y = std::min(min_y, s.y);
+    max_y = std::max(max_y, s.y);
+    double const drift = s.H - evolution[0].H;
+    min_drift = std::min(min_drift, drift);
+    max_drift = std::max(max_drift, drift);
+    sum_drift += drift;
+    if (i > 0 && evolution[i - 1].x < p.d / p.c && s.x >= p.d / p.c)
+      ++crossings;
+  }
+
+  CHECK(analyzer->min_x() == min_x);
+  CHECK(analyzer->max_x() == max_x);
+  CHECK(analyzer->min_y() == min_y);
+  CHECK(analyzer->max_y() == max_y);
+  CHECK(analyzer->amplitude_x() == doctest::Approx((max_x - min_x) / 2));
+  CHECK(analyzer->drift_min() == doctest::Approx(min_drift));
+  CHECK(analyzer->drift_max() == doctest::Approx(max_drift));
+  CHECK(analyzer->drift_mean() ==
+        doctest::Approx(sum_drift / static_cast<double>(evolution.size())));
+  CHECK(analyzer->drift() ==
+        doctest::Approx(evolution.back().H - evolution[0].H));
+  CHECK(analyzer->crossings() == crossings);
+  CHECK(crossings >= std::size_t(2));
+}
@@ -0,0 +1,146 @@
+#include "orbit_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+
+namespace volterra {
+
+namespace {
+
+// bound on the steps spent looking for the closure of a canonical orbit
+constexpr double max_steps{1e8};
+
+// polar angle of (x, y) around the equilibrium of the canonical model
+double angle_of(double x, double y) { return std::atan2(y - 1., x - 1.); }
+
+// closest point to (x, y) on the segment p-q: squared distance and time
+void project(State const& p, State const& q, double x, double y,
+             double& best_distance, double& best_time) {
+  double const dx = q.x - p.x;
+  double const dy = q.y - p.y;
+  double const length2 = dx * dx + dy * dy;
+  double w = length2 > 0 ? ((x - p.x) * dx + (y - p.y) * dy) / length2 : 0.;
+  w = std::clamp(w, 0., 1.);
+  double const ex = p.x + w * dx - x;
+  double const ey = p.y + w * dy - y;
+  double const distance = ex * ex + ey * ey;
+  if (distance < best_distance) {
+    best_distance = distance;
+    best_time = p.t + w * (q.t - p.t);
+  }
+}
+
+// canonical time at which the sampled orbit passes closest to (x, y): the
+// segment with the same angle, or one next to it
+double phase_of(std::vector<State> const& samples,
+                std::vector<double> const& angles, double turn, double x,
+                double y) {
+  constexpr double turn_angle{2 * std::numbers::pi};
+  // the same direction, within the first turn covered by the samples
+  double const offset =
+      std::fmod(turn * angle_of(x, y) - angles.front(), turn_angle);
+  double const target =
+      angles.front() + (offset < 0 ? offset + turn_angle : offset);
+
+  std::size_t const n = samples.size();
+  auto const above = std::upper_bound(angles.begin(), angles.end(), target);
+  std::size_t const segment =
+      std::clamp<std::size_t>(
+          static_cast<std::size_t>(above - angles.begin()), 1, n - 1) -
+      1;
+
+  double best_distance{std::numeric_limits<double>::infinity()};
+  double best_time{samples.front().t};
+  std::size_t const last = std::min(segment + 1, n - 2);
+  for (std::size_t i = segment == 0 ? 0 : segment - 1; i <= last; ++i) {
+    project(samples[i], samples[i + 1], x, y, best_distance, best_time);
+  }
+  return best_time;
+}
+
+}  // namespace
+
+//-------------------------CONSTRUCTORS-------------------------------
+
+OrbitCache::OrbitCache(double resolution, double step)
+    : resolution_(resolution), step_(step) {
+  if (!(resolution > 0) || !(step > 0))
+    throw std::invalid_argument("Invalid input.");
+}
+
+//--------------------------PUBLIC FUNCTIONS-----------------------
+
+// ORBIT()
+std::shared_ptr<PeriodicOrbit const> OrbitCache::orbit(Parameters const& p,
+                                                       State const& state) {
+  double const rho = p.d / p.a;
+  double const X = state.x * p.c / p.d;
+  double const Y = state.y * p.b / p.a;
+  double const K = rho * (X - std::log(X)) + (Y - std::log(Y));
+  double const excess = K - (1 + rho);
+  if (!(excess > 1e-12)) return nullptr;
+
+  Key const key{
+      static_cast<std::int64_t>(std::llround(std::log(rho) / resolution_)),
+      static_cast<std::int64_t>(std::llround(std::log(excess) / resolution_))};
+
+  auto found = orbits_.find(key);
+  if (found != orbits_.end()) {
+    ++hits_;
+  } else {
+    ++misses_;
+    // the canonical model is the original one with a = b = 1, c = d = rho:
+    // there physical and relative coordinates coincide and H = K
+    BasicSimulation<LogYoshida6> canonical({1., 1., rho, rho}, X, Y, step_,
+                                           max_steps);
+    canonical.set_sink(std::make_shared<RingSink<State>>(1));
+    canonical.set_fast_forward(1e-10);
+    canonical.go();
+    if (canonical.orbit() == nullptr)
+      throw std::runtime_error("The canonical orbit did not close.");
+    Entry entry{std::make_shared<PeriodicOrbit const>(*canonical.orbit()),
+                {},
+                1.};
+    auto const& samples = entry.orbit->samples();
+    entry.angles.reserve(samples.size());
+    double previous = angle_of(samples.front().x, samples.front().y);
+    entry.angles.push_back(previous);
+    for (std::size_t i{1}; i < samples.size(); ++i) {
+      double const angle = angle_of(samples[i].x, samples[i].y);
+      entry.angles.push_back(entry.angles.back() +
+                             std::remainder(angle - previous,
+                                            2 * std::numbers::pi));
+      previous = angle;
+    }
+    if (entry.angles.back() < entry.angles.front()) {
+      entry.turn = -1.;
+      for (double& angle : entry.angles) angle = -angle;
+    }
+    found = orbits_.emplace(key, std::move(entry)).first;
+  }
+
+  Entry const& entry = found->second;
+  PeriodicOrbit const& canonical = *entry.orbit;
+  double const tau =
+      phase_of(canonical.samples(), entry.angles, entry.turn, X, Y);
+
+  // H = c x + b y - d log x - a log y = a K - d log(d/c) - a log(a/b)
+  double const H_offset =
+      -(p.d * std::log(p.d / p.c) + p.a * std::log(p.a / p.b));
+  return std::make_shared<PeriodicOrbit const>(
+      canonical.rescaled(p.d / p.c, p.a / p.b, p.a, H_offset, p.a,
+                         tau - p.a * state.t));
+}
+
+// KEY HASH
+std::size_t OrbitCache::KeyHash::operator()(Key const& key) const {
+  std::size_t const h1 = std::hash<std::int64_t>{}(key.ratio);
+  std::size_t const h2 = std::hash<std::int64_t>{}(key.level);
+  return h1 ^ (h2 + 0x9e3779b97f4a7c15 + (h1 << 6) + (h1 >> 2));
+}
+
+}  // namespace volterra
@@ -0,0 +1,66 @@
+#ifndef ORBIT_CACHE_HPP
+#define ORBIT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "periodic_orbit.hpp"
+#include "simulation.hpp"
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// Cache of canonical orbits. In the relative coordinates X = x c/d,
+// Y = y b/a and with time tau = a t the model only depends on rho = d/a:
+//   dX/dtau = X (1 - Y),  dY/dtau = rho Y (X - 1),
+// whose orbits are the levels of K = rho (X - log X) + (Y - log Y).
+// Orbits are keyed on (log rho, log(K - K_min)) rounded to resolution, so
+// every run whose parameters and initial state reduce to the same key is
+// answered by rescaling one stored period instead of being integrated.
+// The levels of K are convex curves around the equilibrium (1, 1), so the
+// polar angle around it grows monotonically along an orbit: the phase of a
+// run is found by a binary search on the angles of the samples.
+// Not thread-safe.
+class OrbitCache {
+  struct Key {
+    std::int64_t ratio;
+    std::int64_t level;
+    bool operator==(Key const&) const = default;
+  };
+  struct KeyHash {
+    std::size_t operator()(Key const& key) const;
+  };
+  struct Entry {
+    std::shared_ptr<PeriodicOrbit const> orbit;
+    std::vector<double> angles;  // of the samples, unwrapped, times turn
+    double turn;  // 1 if the angle grows along the orbit, -1 otherwise
+  };
+
+  double resolution_;
+  double step_;  // canonical time step used to integrate new orbits
+  std::unordered_map<Key, Entry, KeyHash> orbits_;
+  std::size_t hits_{0};
+  std::size_t misses_{0};
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  explicit OrbitCache(double resolution = 1e-9, double step = 1e-3);
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  // orbit through state for parameters p, in physical coordinates and time;
+  // nullptr when state is the equilibrium point
+  std::shared_ptr<PeriodicOrbit const> orbit(Parameters const& p,
+                                             State const& state);
+
+  std::size_t size() const { return orbits_.size(); }
+  std::size_t hits() const { return hits_; }
+  std::size_t misses() const { return misses_; }
+};
+
+}  // namespace volterra
+
+#endif
@@ -0,0 +1,91 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "orbit_cache.hpp"
+
+#include <tuple>
+
+#include "doctest.h"
+
+using LogSimulation = volterra::BasicSimulation<volterra::LogYoshida6>;
+
+TEST_CASE("Testing constructor") {
+  CHECK_THROWS(volterra::OrbitCache(0., 1e-3));
+  CHECK_THROWS(volterra::OrbitCache(1e-9, -1.));
+  CHECK_NOTHROW(volterra::OrbitCache());
+}
+
+TEST_CASE("Testing equivalent parameter sets share one orbit") {
+  auto cache = std::make_shared<volterra::OrbitCache>();
+
+  // same d/a and same relative initial state: one canonical orbit
+  volterra::Parameters const p1{1., 0.5, 0.2, 0.8};
+  volterra::Parameters const p2{2., 1., 0.4, 1.6};
+  volterra::Parameters const p3{0.5, 2., 3., 0.4};  // same d/a, rescaled x, y
+
+  LogSimulation first(p1, 8., 6., 0.001, 1e9);
+  LogSimulation second(p2, 8., 6., 0.001, 1e9);
+  LogSimulation third(p3, 8. * 0.2 / 0.8 * 0.4 / 3., 6. * 0.5 * 0.5 / 2.,
+                      0.001, 1e9);
+  for (auto* sim : {&first, &second, &third}) {
+    sim->set_cache(cache);
+    sim->go();
+  }
+
+  CHECK(cache->misses() == std::size_t(1));
+  CHECK(cache->hits() == std::size_t(2));
+  CHECK(cache->size() == std::size_t(1));
+  CHECK(first.steps() == std::size_t(1000000000));
+  REQUIRE(first.orbit() != nullptr);
+  REQUIRE(second.orbit() != nullptr);
+  // doubling every rate halves the period
+  CHECK(second.orbit()->period() ==
+        doctest::Approx(first.orbit()->period() / 2).epsilon(1e-9));
+
+  SUBCASE("cached states match a direct integration") {
+    for (auto [p, x0, y0] : {std::tuple{p1, 8., 6.}, std::tuple{p2, 8., 6.}}) {
+      LogSimulation direct(p, x0, y0, 0.001, 15000.);
+      direct.go();
+      LogSimulation cached(p, x0, y0, 0.001, 15000.);
+      cached.set_cache(cache);
+      cached.go();
+
+      for (std::size_t step : {std::size_t(0), std::size_t(4321),
+                               std::size_t(14999)}) {
+        auto const& expected = direct.evolution()[step];
+        auto const state = cached.state_at(step);
+        CHECK(state.x == doctest::Approx(expected.x).epsilon(1e-5));
+        CHECK(state.y == doctest::Approx(expected.y).epsilon(1e-5));
+        CHECK(state.H == doctest::Approx(expected.H).epsilon(1e-8));
+      }
+      CHECK(cached.current_state().x ==
+            doctest::Approx(direct.current_state().x).epsilon(1e-5));
+    }
+    CHECK(cache->misses() == std::size_t(1));
+  }
+}
+
+TEST_CASE("Testing the phase of every point of an orbit") {
+  // starts spread over one period: each one is found on the cached orbit
+  volterra::Parameters const p{1., 0.5, 0.2, 0.8};
+  LogSimulation direct(p, 8., 6., 0.01, 2000.);
+  direct.go();
+  auto cache = std::make_shared<volterra::OrbitCache>(1e-3);
+  for (std::size_t step{0}; step < 2000; step += 97) {
+    auto const& start = direct.evolution()[step];
+    LogSimulation sim(p, start.x, start.y, 0.01, 1e6);
+    sim.set_cache(cache);
+    sim.go();
+    REQUIRE(sim.orbit() != nullptr);
+    auto const state = sim.state_at(0);
+    CHECK(state.x == doctest::Approx(start.x).epsilon(1e-3));
+    CHECK(state.y == doctest::Approx(start.y).epsilon(1e-3));
+  }
+  CHECK(cache->size() == std::size_t(1));
+}
+
+TEST_CASE("Testing equilibrium is not cached") {
+  volterra::OrbitCache cache;
+  volterra::Parameters const p{1., 0.5, 0.2, 0.8};
+  CHECK(cache.orbit(p, volterra::State{4., 2., 0.}) == nullptr);
+  CHECK(cache.size() == std::size_t(0));
+}
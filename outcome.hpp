@@ -0,0 +1,24 @@
+#ifndef OUTCOME_HPP
+#define OUTCOME_HPP
+
+#include <cstddef>
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+// why a bulk evolve_n() returned
+enum class Status {
+  Completed,     // all the requested steps were taken
+  Extinct,       // a population went extinct (or, on the grid, both did)
+  StepUnderflow  // the adaptive integrator could not meet its tolerance
+};
+
+struct Outcome {
+  Status status;
+  std::size_t step;  // index of the last valid state (0 = initial state)
+};
+
+}  // namespace volterra
+
+#endif
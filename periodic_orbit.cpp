@@ -0,0 +1,65 @@
+#include "periodic_orbit.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace volterra {
+
+//-------------------------CONSTRUCTORS-------------------------------
+
+PeriodicOrbit::PeriodicOrbit(std::vector<State> samples, double reference,
+                             double period)
+    : samples_(std::make_shared<std::vector<State> const>(std::move(samples))),
+      reference_(reference),
+      period_(period) {
+  if (!(period > 0) || samples_->size() < 2 ||
+      samples_->front().t > reference ||
+      samples_->back().t < reference + period)
+    throw std::invalid_argument("Invalid input.");
+}
+
+//--------------------------PUBLIC FUNCTIONS-----------------------
+
+// AT()
+State PeriodicOrbit::at(double t) const {
+  double const tau_0 = time_scale_ * t + time_offset_;
+  double phase = std::fmod(tau_0 - reference_, period_);
+  if (phase < 0) phase += period_;
+  double const tau = reference_ + phase;
+
+  // first sample after tau, the one before it is at most tau
+  auto const after = std::upper_bound(
+      samples_->begin(), samples_->end(), tau,
+      [](double value, State const& sample) { return value < sample.t; });
+
+  State sample = samples_->back();
+  if (after != samples_->end()) {
+    auto const before = std::prev(after);
+    double const w = (tau - before->t) / (after->t - before->t);
+    sample = State{before->x + w * (after->x - before->x),
+                   before->y + w * (after->y - before->y),
+                   before->H + w * (after->H - before->H)};
+  }
+
+  return State{x_scale_ * sample.x, y_scale_ * sample.y,
+               H_scale_ * sample.H + H_offset_, t};
+}
+
+// RESCALED()
+PeriodicOrbit PeriodicOrbit::rescaled(double x_scale, double y_scale,
+                                      double H_scale, double H_offset,
+                                      double time_scale,
+                                      double time_offset) const {
+  PeriodicOrbit copy{*this};
+  copy.x_scale_ = x_scale_ * x_scale;
+  copy.y_scale_ = y_scale_ * y_scale;
+  copy.H_scale_ = H_scale_ * H_scale;
+  copy.H_offset_ = H_scale * H_offset_ + H_offset;
+  copy.time_scale_ = time_scale_ * time_scale;
+  copy.time_offset_ = time_scale_ * time_offset + time_offset_;
+  return copy;
+}
+
+}  // namespace volterra
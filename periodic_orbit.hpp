@@ -0,0 +1,53 @@
+#ifndef PERIODIC_ORBIT_HPP
+#define PERIODIC_ORBIT_HPP
+
+#include <memory>
+#include <vector>
+
+#include "simulation.hpp"
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// One closed orbit of the continuous model, stored as the states of (at
+// least) one full period. Any later state is answered by reducing its time
+// modulo the period and interpolating linearly between the two nearest
+// samples, so the cost does not depend on how far in time it lies.
+//
+// The samples are shared between copies. rescaled() returns the same orbit
+// seen through an affine change of coordinates and time, which is how the
+// canonical orbits of OrbitCache serve every equivalent parameter set.
+class PeriodicOrbit {
+  std::shared_ptr<std::vector<State> const> samples_;  // increasing t,
+  // covering [reference_, reference_ + period_], in sample time
+  double reference_;  // time of a section crossing
+  double period_;
+
+  // sample values to returned values: x_scale_ X, y_scale_ Y,
+  // H_scale_ H + H_offset_, sample time = time_scale_ t + time_offset_
+  double x_scale_{1.};
+  double y_scale_{1.};
+  double H_scale_{1.};
+  double H_offset_{0.};
+  double time_scale_{1.};
+  double time_offset_{0.};
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  PeriodicOrbit(std::vector<State> samples, double reference, double period);
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  std::vector<State> const& samples() const { return *samples_; }
+  double period() const { return period_ / time_scale_; }
+
+  State at(double t) const;
+
+  PeriodicOrbit rescaled(double x_scale, double y_scale, double H_scale,
+                         double H_offset, double time_scale,
+                         double time_offset) const;
+};
+
+}  // namespace volterra
+
+#endif
@@ -0,0 +1,184 @@
+#include "phase_portrait.hpp"
+
+#include "ensemble.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace volterra {
+
+namespace {
+
+constexpr std::size_t block_orbits{64};  // orbits per task
+
+// colors cycled over the orbits
+constexpr std::array<char const*, 6> palette{
+    "#1b9e77", "#d95f02", "#7570b3", "#e7298a", "#66a61e", "#a6761d"};
+
+}  // namespace
+
+// LATTICE()
+std::vector<PhasePoint> lattice(PhaseBox const& box, std::size_t nx,
+                                std::size_t ny) {
+  if (nx == 0 || ny == 0 || !(box.x_max > box.x_min) ||
+      !(box.y_max > box.y_min)) {
+    throw std::invalid_argument("Invalid input.");
+  }
+  std::vector<PhasePoint> points;
+  points.reserve(nx * ny);
+  double const dx = (box.x_max - box.x_min) / static_cast<double>(nx);
+  double const dy = (box.y_max - box.y_min) / static_cast<double>(ny);
+  for (std::size_t j{0}; j < ny; ++j) {
+    for (std::size_t i{0}; i < nx; ++i) {
+      points.push_back({box.x_min + (static_cast<double>(i) + 0.5) * dx,
+                        box.y_min + (static_cast<double>(j) + 0.5) * dy});
+    }
+  }
+  return points;
+}
+
+// LEVEL_STARTS()
+// On y = a/b, H = c x - d log x + const grows with x for x > d/c: the point
+// of each level is found by bisection.
+std::vector<PhasePoint> level_starts(Parameters const& p,
+                                     std::vector<double> const& levels) {
+  if (p.a <= 0 || p.b <= 0 || p.c <= 0 || p.d <= 0) {
+    throw std::invalid_argument("Invalid input.");
+  }
+  double const y = p.a / p.b;
+  auto H = [&](double x) {
+    return p.c * x + p.b * y - p.d * std::log(x) - p.a * std::log(y);
+  };
+  double const x_eq = p.d / p.c;
+
+  std::vector<PhasePoint> points;
+  for (double level : levels) {
+    // levels below the minimum by rounding only start at the equilibrium
+    double const H_eq = H(x_eq);
+    if (!(level >= H_eq - 1e-12 * std::abs(H_eq)) || !std::isfinite(level)) {
+      throw std::invalid_argument("Invalid input.");
+    }
+    double low = x_eq;
+    double high = 2 * x_eq;
+    while (H(high) < level) high *= 2;
+    for (int i = 0; i < 200 && high - low > 1e-15 * high; ++i) {
+      double const middle = (low + high) / 2;
+      (H(middle) < level ? low : high) = middle;
+    }
+    points.push_back({(low + high) / 2, y});
+  }
+  return points;
+}
+
+// INTEGRATE_ORBITS()
+std::vector<Orbit> integrate_orbits(Parameters const& p,
+                                    std::vector<PhasePoint> const& starts,
+                                    double dt, std::size_t steps,
+                                    std::size_t stride, ThreadPool& pool) {
+  if (stride == 0) throw std::invalid_argument("Invalid input.");
+  std::vector<Orbit> orbits(starts.size());
+  std::size_t const blocks = (starts.size() + block_orbits - 1) / block_orbits;
+
+  parallel_for(pool, blocks, [&](std::size_t block) {
+    std::size_t const first = block * block_orbits;
+    std::size_t const last = std::min(first + block_orbits, starts.size());
+    Ensemble ensemble;
+    ensemble.reserve(last - first);
+    for (std::size_t i{first}; i < last; ++i) {
+      ensemble.add(p, starts[i].x, starts[i].y, dt);
+      orbits[i].x.reserve(steps / stride + 2);
+      orbits[i].y.reserve(steps / stride + 2);
+    }
+
+    auto record = [&] {
+      for (std::size_t lane{0}; lane < ensemble.size(); ++lane) {
+        if (!ensemble.alive(lane)) continue;
+        State const state = ensemble.state(lane);
+        orbits[first + lane].x.push_back(state.x);
+        orbits[first + lane].y.push_back(state.y);
+      }
+    };
+    record();
+    for (std::size_t done{0}; done < steps;) {
+      std::size_t const n = std::min(stride, steps - done);
+      ensemble.evolve_n(n);
+      done += n;
+      record();
+      if (ensemble.alive_count() == 0) break;
+    }
+    for (std::size_t lane{0}; lane < ensemble.size(); ++lane) {
+      orbits[first + lane].alive = ensemble.alive(lane);
+    }
+  });
+  return orbits;
+}
+
+// VECTOR_FIELD()
+std::vector<Arrow> vector_field(Parameters const& p, PhaseBox const& box,
+                                std::size_t nx, std::size_t ny) {
+  std::vector<PhasePoint> const centers = lattice(box, nx, ny);
+  double const cell_x = (box.x_max - box.x_min) / static_cast<double>(nx);
+  double const cell_y = (box.y_max - box.y_min) / static_cast<double>(ny);
+
+  std::vector<Arrow> arrows;
+  arrows.reserve(centers.size());
+  for (auto const& [x, y] : centers) {
+    // in cell units, so that every arrow spans 0.8 cells on screen
+    double const u = (p.a * x - p.b * x * y) / cell_x;
+    double const v = (p.c * x * y - p.d * y) / cell_y;
+    double const norm = std::hypot(u, v);
+    if (!(norm > 0)) continue;
+    double const dx = 0.8 * cell_x * u / norm;
+    double const dy = 0.8 * cell_y * v / norm;
+    arrows.push_back({x - dx / 2, y - dy / 2, dx, dy});
+  }
+  return arrows;
+}
+
+// ENCLOSING()
+PhaseBox enclosing(std::vector<Orbit> const& orbits, double margin) {
+  double const inf = std::numeric_limits<double>::infinity();
+  PhaseBox box{inf, -inf, inf, -inf};
+  for (auto const& orbit : orbits) {
+    for (std::size_t i{0}; i < orbit.x.size(); ++i) {
+      box.x_min = std::min(box.x_min, orbit.x[i]);
+      box.x_max = std::max(box.x_max, orbit.x[i]);
+      box.y_min = std::min(box.y_min, orbit.y[i]);
+      box.y_max = std::max(box.y_max, orbit.y[i]);
+    }
+  }
+  if (!(box.x_max > box.x_min) || !(box.y_max > box.y_min)) {
+    throw std::invalid_argument("Invalid input.");
+  }
+  double const wx = margin * (box.x_max - box.x_min);
+  double const wy = margin * (box.y_max - box.y_min);
+  return {std::max(0., box.x_min - wx), box.x_max + wx,
+          std::max(0., box.y_min - wy), box.y_max + wy};
+}
+
+// SAVE_PHASE_PORTRAIT()
+void save_phase_portrait(std::string const& filename, PhaseBox const& box,
+                         std::vector<Orbit> const& orbits,
+                         std::vector<Arrow> const& field) {
+  PlotStyle style{"PHASE PORTRAIT", "PREY", "PREDATORS"};
+  style.x_min = box.x_min;
+  style.x_max = box.x_max;
+  style.y_min = box.y_min;
+  style.y_max = box.y_max;
+  style.downsample = false;  // x goes back and forth along an orbit
+
+  std::vector<Series> series;
+  series.reserve(orbits.size());
+  for (std::size_t i{0}; i < orbits.size(); ++i) {
+    Orbit const& orbit = orbits[i];
+    series.push_back(Series{"", palette[i % palette.size()], orbit.x.size(),
+                            [&orbit](std::size_t k) { return orbit.x[k]; },
+                            [&orbit](std::size_t k) { return orbit.y[k]; }});
+  }
+  save_svg(filename, style, series, field);
+}
+
+}  // namespace volterra
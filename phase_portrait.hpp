@@ -0,0 +1,68 @@
+#ifndef PHASE_PORTRAIT_HPP
+#define PHASE_PORTRAIT_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "simulation.hpp"
+#include "svg_plot.hpp"
+#include "thread_pool.hpp"
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+// a rectangle of the phase plane (prey x, predators y)
+struct PhaseBox {
+  double x_min;
+  double x_max;
+  double y_min;
+  double y_max;
+};
+
+struct PhasePoint {
+  double x;
+  double y;
+};
+
+// one orbit, sampled every stride steps from its start
+struct Orbit {
+  std::vector<double> x;
+  std::vector<double> y;
+  bool alive{true};  // false if the discrete orbit went extinct
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// starting points: the centers of an nx by ny lattice of the box, or one
+// point per level of H, on the half-line y = a/b, x > d/c (throws if a
+// level is below the minimum of H, reached at the equilibrium)
+std::vector<PhasePoint> lattice(PhaseBox const& box, std::size_t nx,
+                                std::size_t ny);
+std::vector<PhasePoint> level_starts(Parameters const& p,
+                                     std::vector<double> const& levels);
+
+// Integrates every orbit with the batched Ensemble kernel (the same update
+// as Simulation), blocks of orbits running in parallel on the pool.
+std::vector<Orbit> integrate_orbits(Parameters const& p,
+                                    std::vector<PhasePoint> const& starts,
+                                    double dt, std::size_t steps,
+                                    std::size_t stride, ThreadPool& pool);
+
+// direction of (dx/dt, dy/dt) at the centers of an nx by ny lattice, as
+// arrows of the same length on screen (none at the equilibrium)
+std::vector<Arrow> vector_field(Parameters const& p, PhaseBox const& box,
+                                std::size_t nx, std::size_t ny);
+
+// the box holding every recorded point, widened by margin on each side
+PhaseBox enclosing(std::vector<Orbit> const& orbits, double margin = 0.05);
+
+// orbits and field in one plot of the box
+void save_phase_portrait(std::string const& filename, PhaseBox const& box,
+                         std::vector<Orbit> const& orbits,
+                         std::vector<Arrow> const& field);
+
+}  // namespace volterra
+
+#endif
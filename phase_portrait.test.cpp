@@ -0,0 +1,156 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "phase_portrait.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "doctest.h"
+
+namespace {
+
+double H(volterra::Parameters const& p, double x, double y) {
+  return p.c * x + p.b * y - p.d * std::log(x) - p.a * std::log(y);
+}
+
+}  // namespace
+
+TEST_CASE("Testing lattice()") {
+  auto const points = volterra::lattice({0., 4., 10., 12.}, 4, 2);
+  REQUIRE(points.size() == std::size_t(8));
+  CHECK(points[0].x == 0.5);
+  CHECK(points[0].y == 10.5);
+  CHECK(points[7].x == 3.5);
+  CHECK(points[7].y == 11.5);
+
+  CHECK_THROWS(volterra::lattice({0., 4., 10., 12.}, 0, 2));
+  CHECK_THROWS(volterra::lattice({4., 4., 10., 12.}, 3, 2));
+}
+
+TEST_CASE("Testing level_starts()") {
+  volterra::Parameters const p{2., 1., 1., 3.};
+  double const H_min = H(p, 3., 2.);
+  std::vector<double> const levels{H_min, H_min + 0.5, H_min + 4.};
+
+  auto const points = volterra::level_starts(p, levels);
+  REQUIRE(points.size() == levels.size());
+  CHECK(points[0].x == doctest::Approx(3.).epsilon(1e-6));
+  for (std::size_t i{0}; i < points.size(); ++i) {
+    CHECK(points[i].x >= 3.);
+    CHECK(points[i].y == 2.);
+    CHECK(H(p, points[i].x, points[i].y) ==
+          doctest::Approx(levels[i]).epsilon(1e-12));
+  }
+
+  CHECK_THROWS(volterra::level_starts(p, {H_min - 0.1}));
+  CHECK_THROWS(volterra::level_starts({0., 1., 1., 3.}, {H_min}));
+}
+
+TEST_CASE("Testing integrate_orbits() against Simulation") {
+  volterra::Parameters const p{2., 1., 1., 3.};
+  double const dt{0.001};
+  std::size_t const steps{1000};
+  std::size_t const stride{100};
+  // more orbits than a block
+  auto const starts = volterra::lattice({1., 8., 1., 6.}, 10, 10);
+  volterra::ThreadPool pool{3};
+
+  auto const orbits =
+      volterra::integrate_orbits(p, starts, dt, steps, stride, pool);
+  REQUIRE(orbits.size() == starts.size());
+
+  for (std::size_t i{0}; i < orbits.size(); i += 13) {
+    volterra::Simulation sim(p, starts[i].x, starts[i].y, dt,
+                             static_cast<double>(steps + 1));
+    sim.go();
+    auto const& evolution = sim.evolution();
+
+    CHECK(orbits[i].alive);
+    REQUIRE(orbits[i].x.size() == steps / stride + 1);
+    for (std::size_t k{0}; k < orbits[i].x.size(); ++k) {
+      CHECK(orbits[i].x[k] ==
+            doctest::Approx(evolution[k * stride].x).epsilon(1e-12));
+      CHECK(orbits[i].y[k] ==
+            doctest::Approx(evolution[k * stride].y).epsilon(1e-12));
+    }
+  }
+
+  // a last stride shorter than the others
+  auto const short_last =
+      volterra::integrate_orbits(p, {{4., 2.}}, dt, 250, 100, pool);
+  CHECK(short_last[0].x.size() == std::size_t(4));
+
+  CHECK_THROWS(volterra::integrate_orbits(p, starts, dt, steps, 0, pool));
+  CHECK_THROWS(volterra::integrate_orbits(p, {{-1., 2.}}, dt, steps, 1, pool));
+}
+
+TEST_CASE("Testing integrate_orbits() speed") {
+  volterra::Parameters const p{2., 1., 1., 3.};
+  std::vector<double> levels;
+  for (int i{1}; i <= 400; ++i) levels.push_back(H(p, 3., 2.) + 0.01 * i);
+  auto const starts = volterra::level_starts(p, levels);
+  volterra::ThreadPool pool;
+
+  auto const begin = std::chrono::steady_clock::now();
+  auto const orbits =
+      volterra::integrate_orbits(p, starts, 0.001, 5000, 10, pool);
+  std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - begin;
+
+  CHECK(orbits.size() == std::size_t(400));
+  // loose bound, the checks of a debug build included
+  CHECK(elapsed.count() < 5.);
+}
+
+TEST_CASE("Testing vector_field()") {
+  volterra::Parameters const p{2., 1., 1., 3.};
+  volterra::PhaseBox const box{0., 6., 0., 4.};
+  // the center of the middle cell is the equilibrium (3, 2)
+  auto const arrows = volterra::vector_field(p, box, 3, 3);
+  REQUIRE(arrows.size() == std::size_t(8));
+
+  for (auto const& arrow : arrows) {
+    double const x = arrow.x + arrow.dx / 2;
+    double const y = arrow.y + arrow.dy / 2;
+    double const u = p.a * x - p.b * x * y;
+    double const v = p.c * x * y - p.d * y;
+    // along the field, 0.8 cells (2 by 4/3) long
+    CHECK(arrow.dx * v == doctest::Approx(arrow.dy * u));
+    CHECK(std::hypot(arrow.dx / 2., arrow.dy * 3. / 4.) ==
+          doctest::Approx(0.8));
+    CHECK(arrow.dx * u + arrow.dy * v > 0.);
+  }
+}
+
+TEST_CASE("Testing save_phase_portrait()") {
+  volterra::Parameters const p{2., 1., 1., 3.};
+  volterra::ThreadPool pool{2};
+  auto const orbits = volterra::integrate_orbits(
+      p, volterra::level_starts(p, {6., 7., 8.}), 0.001, 5000, 10, pool);
+  auto const box = volterra::enclosing(orbits);
+  CHECK(box.x_min >= 0.);
+  CHECK(box.x_min < 3.);
+  CHECK(box.x_max > 3.);
+
+  std::string const filename{"phase_portrait_test.svg"};
+  volterra::save_phase_portrait(filename, box, orbits,
+                                volterra::vector_field(p, box, 10, 8));
+  std::ifstream in{filename};
+  std::stringstream text;
+  text << in.rdbuf();
+  std::string const svg = text.str();
+  in.close();
+  std::remove(filename.c_str());
+
+  std::size_t polylines{0};
+  for (auto i = svg.find("<polyline"); i != std::string::npos;
+       i = svg.find("<polyline", i + 1)) {
+    ++polylines;
+  }
+  CHECK(polylines == std::size_t(3));
+  CHECK(svg.find("marker-end") != std::string::npos);
+  CHECK(svg.find("PREDATORS") != std::string::npos);
+}
@@ -0,0 +1,64 @@
+#include "runner.hpp"
+
+#include <exception>
+
+namespace volterra {
+
+namespace {
+
+// RUN_CONTINUOUS()
+void run_continuous(ContinuousRun const& spec, RunResult& result) {
+  Simulation simulation{spec.parameters, spec.x, spec.y, spec.dt,
+                        spec.iterations};
+  simulation.set_sink(spec.sink ? spec.sink
+                                : std::make_shared<RingSink<State>>(1));
+  auto const total = static_cast<std::size_t>(simulation.iterations());
+  result.outcome = simulation.steps() < total
+                       ? simulation.evolve_n(total - simulation.steps())
+                       : Outcome{Status::Completed, simulation.steps() - 1};
+  simulation.flush();
+  result.state = simulation.current_state();
+}
+
+// RUN_GRID()
+void run_grid(GridRun const& spec, RunResult& result) {
+  wator::GridSimulation simulation{spec.parameters, spec.seed};
+  simulation.set_sink(
+      spec.sink ? spec.sink
+                : std::make_shared<RingSink<wator::Population>>(1));
+  std::size_t const total = simulation.iterations();
+  result.outcome = simulation.steps() < total
+                       ? simulation.evolve_n(total - simulation.steps())
+                       : Outcome{Status::Completed, simulation.steps() - 1};
+  simulation.sink().flush();
+  result.population = simulation.current_population();
+}
+
+}  // namespace
+
+// RUN()
+RunResult run(RunSpec const& spec) {
+  RunResult result;
+  try {
+    if (auto const* continuous = std::get_if<ContinuousRun>(&spec)) {
+      run_continuous(*continuous, result);
+    } else {
+      run_grid(std::get<GridRun>(spec), result);
+    }
+    result.valid = true;
+  } catch (std::exception const& e) {
+    result.error = e.what();
+  }
+  return result;
+}
+
+// RUN_ENSEMBLE()
+std::vector<RunResult> run_ensemble(std::vector<RunSpec> const& runs,
+                                    ThreadPool& pool) {
+  std::vector<RunResult> results(runs.size());
+  parallel_for(pool, runs.size(),
+               [&](std::size_t i) { results[i] = run(runs[i]); });
+  return results;
+}
+
+}  // namespace volterra
@@ -0,0 +1,63 @@
+#ifndef RUNNER_HPP
+#define RUNNER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "grid_simulation.hpp"
+#include "outcome.hpp"
+#include "simulation.hpp"
+#include "sink.hpp"
+#include "thread_pool.hpp"
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+// one Simulation, run for iterations states
+struct ContinuousRun {
+  Parameters parameters;
+  double x;
+  double y;
+  double dt;
+  double iterations;
+  // destination of the states; by default only the last one is kept
+  std::shared_ptr<Sink<State>> sink{};
+};
+
+// one GridSimulation, run for parameters.iterations states (or until the
+// grid is empty)
+struct GridRun {
+  wator::GridParameters parameters;
+  unsigned seed;
+  std::shared_ptr<Sink<wator::Population>> sink{};
+};
+
+using RunSpec = std::variant<ContinuousRun, GridRun>;
+
+struct RunResult {
+  bool valid{false};  // false if the run could not be built or failed
+  std::string error;  // what() of the exception, if any
+  Outcome outcome{Status::Completed, 0};
+  State state{};                   // last state of a ContinuousRun
+  wator::Population population{};  // last population of a GridRun
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// Runs every spec as one task of the pool and returns one result per spec,
+// in the same order. Each task writes only its own preallocated slot, and a
+// run that throws (e.g. invalid input) is reported in its slot instead of
+// stopping the others.
+std::vector<RunResult> run_ensemble(std::vector<RunSpec> const& runs,
+                                    ThreadPool& pool);
+
+// runs a single spec on the calling thread
+RunResult run(RunSpec const& spec);
+
+}  // namespace volterra
+
+#endif
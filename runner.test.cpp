@@ -0,0 +1,141 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "runner.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+#include "doctest.h"
+
+TEST_CASE("Testing the thread pool") {
+  volterra::ThreadPool pool(4);
+  CHECK(pool.size() == 4);
+
+  SUBCASE("every task runs once") {
+    std::vector<int> hits(1000, 0);
+    volterra::parallel_for(pool, hits.size(),
+                           [&](std::size_t i) { ++hits[i]; });
+    for (int hit : hits) CHECK(hit == 1);
+  }
+
+  SUBCASE("tasks can submit tasks") {
+    std::atomic<int> count{0};
+    for (int i = 0; i < 10; ++i) {
+      pool.submit([&] {
+        for (int j = 0; j < 10; ++j) pool.submit([&] { ++count; });
+      });
+    }
+    pool.wait();
+    CHECK(count == 100);
+  }
+
+  SUBCASE("the first exception is rethrown by wait()") {
+    pool.submit([] { throw std::runtime_error("failed"); });
+    pool.submit([] {});
+    CHECK_THROWS_AS(pool.wait(), std::runtime_error);
+    // the pool stays usable
+    std::atomic<int> count{0};
+    pool.submit([&] { ++count; });
+    CHECK_NOTHROW(pool.wait());
+    CHECK(count == 1);
+  }
+
+  SUBCASE("wait() on an idle pool returns") { CHECK_NOTHROW(pool.wait()); }
+
+  SUBCASE("parallel_for() can be nested") {
+    std::atomic<int> count{0};
+    volterra::parallel_for(pool, 8, [&](std::size_t) {
+      volterra::parallel_for(pool, 50, [&](std::size_t) { ++count; });
+    });
+    CHECK(count == 400);
+  }
+
+  SUBCASE("parallel_for() rethrows the exceptions of its tasks") {
+    CHECK_THROWS_AS(volterra::parallel_for(pool, 10,
+                                           [](std::size_t i) {
+                                             if (i == 3) {
+                                               throw std::runtime_error("3");
+                                             }
+                                           }),
+                    std::runtime_error);
+    CHECK_NOTHROW(pool.wait());
+  }
+
+  SUBCASE("wait() from a task throws") {
+    std::atomic<bool> thrown{false};
+    pool.submit([&] {
+      try {
+        pool.wait();
+      } catch (std::logic_error const&) {
+        thrown = true;
+      }
+    });
+    pool.wait();
+    CHECK(thrown);
+  }
+}
+
+TEST_CASE("Testing run_ensemble() against sequential runs") {
+  volterra::Parameters const p{1., 0.5, 0.2, 0.8};
+  wator::GridParameters const g{40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1};
+
+  std::vector<volterra::RunSpec> runs;
+  for (int i = 0; i < 20; ++i) {
+    runs.push_back(volterra::ContinuousRun{p, 3. + i, 2., 0.001, 2000.});
+    runs.push_back(volterra::GridRun{g, static_cast<unsigned>(i)});
+  }
+
+  volterra::ThreadPool pool(3);
+  auto const results = volterra::run_ensemble(runs, pool);
+  REQUIRE(results.size() == runs.size());
+
+  for (int i = 0; i < 20; ++i) {
+    auto const& continuous = results[static_cast<std::size_t>(2 * i)];
+    volterra::Simulation sim(p, 3. + i, 2., 0.001, 2000.);
+    sim.go();
+    CHECK(continuous.valid);
+    CHECK(continuous.outcome.status == volterra::Status::Completed);
+    CHECK(continuous.outcome.step == 1999);
+    CHECK(continuous.state == sim.current_state());
+    CHECK(continuous.state.H == sim.current_state().H);
+
+    auto const& grid = results[static_cast<std::size_t>(2 * i + 1)];
+    wator::GridSimulation wator(g, static_cast<unsigned>(i));
+    wator.go();
+    CHECK(grid.valid);
+    CHECK(grid.outcome.step == 24);
+    CHECK(grid.population == wator.current_population());
+  }
+}
+
+TEST_CASE("Testing run_ensemble() reports invalid runs in their slot") {
+  volterra::Parameters const p{1., 0.5, 0.2, 0.8};
+  wator::GridParameters const bad_grid{0, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1};
+  std::vector<volterra::RunSpec> const runs{
+      volterra::ContinuousRun{p, 3., 2., 0.001, 100.},
+      volterra::ContinuousRun{p, -3., 2., 0.001, 100.},
+      volterra::GridRun{bad_grid, 1},
+  };
+
+  volterra::ThreadPool pool(2);
+  auto const results = volterra::run_ensemble(runs, pool);
+  CHECK(results[0].valid);
+  CHECK(results[0].outcome.step == 99);
+  CHECK_FALSE(results[1].valid);
+  CHECK(results[1].error == "Invalid input.");
+  CHECK_FALSE(results[2].valid);
+  CHECK_FALSE(results[2].error.empty());
+}
+
+TEST_CASE("Testing run_ensemble() with a custom sink") {
+  volterra::Parameters const p{1., 0.5, 0.2, 0.8};
+  auto sink = std::make_shared<volterra::VectorSink<volterra::State>>();
+  std::vector<volterra::RunSpec> const runs{
+      volterra::ContinuousRun{p, 3., 2., 0.001, 50., sink}};
+
+  volterra::ThreadPool pool(1);
+  auto const results = volterra::run_ensemble(runs, pool);
+  CHECK(results[0].valid);
+  REQUIRE(sink->data().size() == 50);
+  CHECK(sink->data().back() == results[0].state);
+}
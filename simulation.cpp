@@ -1,5 +1,11 @@
 #include "simulation.hpp"
 
+#include "orbit_analyzer.hpp"
+#include "orbit_cache.hpp"
+#include "periodic_orbit.hpp"
+#include "svg_plot.hpp"
+#include "text_export.hpp"
+
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
@@ -10,110 +16,404 @@ namespace volterra {
 //-------------------------CONSTRUCTORS-------------------------------
 
 // MAIN CONSTRUCTOR
-Simulation::Simulation(Parameters p_, double x_, double y_, double dt_,
-                       double it_)
-    : parameters_(p_), timescale_(dt_), iterations_(it_) {
-  if (it_ <= 0.0 || std::floor(it_) != it_ || x_ <= 0 || y_ <= 0 || dt_ <= 0 ||
-      p_.a <= 0 || p_.b <= 0 || p_.c <= 0 || p_.d <= 0)
-    throw std::invalid_argument("Invalid input.");
+template <typename Integrator>
+BasicSimulation<Integrator>::BasicSimulation(Parameters p_, double x_,
+                                             double y_, double dt_,
+                                             double it_,
+                                             Integrator integrator_0)
+    : integrator_(std::move(integrator_0)),
+      parameters_(p_),
+      timescale_(dt_),
+      iterations_(it_),
+      steps_(1),
+      sink_(std::make_shared<VectorSink<State>>()) {
+  validate(p_, x_, y_, dt_, it_);
 
   state_.H = (parameters_.c * x_) + (parameters_.b * y_) -
              ((parameters_.d * std::log(x_)) + (parameters_.a * std::log(y_)));
 
-  evolution_.push_back(State{x_, y_, state_.H});
+  initial_ = State{x_, y_, state_.H};
+  current_ = initial_;
+  sink_->push(current_);
 
   // Coordinate change
   state_.x = x_ * parameters_.c / parameters_.d;
   state_.y = y_ * parameters_.b / parameters_.a;
+  if constexpr (logarithmic_v<Integrator>) {
+    state_.x = std::log(state_.x);
+    state_.y = std::log(state_.y);
+  }
+  log_offset_ = parameters_.d * std::log(parameters_.d / parameters_.c) +
+                parameters_.a * std::log(parameters_.a / parameters_.b);
+  recorded_ = state_;
 }
 
 //--------------------------PUBLIC FUNCTIONS-----------------------
 
 // EVOLVE()
-void Simulation::evolve() {
-  auto x_rel = state_.x;
-  auto y_rel = state_.y;
+template <typename Integrator>
+void BasicSimulation<Integrator>::evolve() {
+  Status const status = advance();
+  if (status != Status::Completed) {
+    throw std::runtime_error(message(status));
+  }
+}
 
-  auto y_rel_new = y_rel + parameters_.d * (x_rel - 1) * y_rel * timescale_;
-  auto x_rel_new = x_rel + parameters_.a * (1 - y_rel_new) * x_rel * timescale_;
+// EVOLVE_N()
+template <typename Integrator>
+Outcome BasicSimulation<Integrator>::evolve_n(std::size_t count) {
+  for (std::size_t i{0}; i < count && state_.t < end_time_; ++i) {
+    Status const status = advance();
+    if (status != Status::Completed) return Outcome{status, steps_ - 1};
+  }
+  return Outcome{Status::Completed, steps_ - 1};
+}
 
+// GO()
+template <typename Integrator>
+void BasicSimulation<Integrator>::go() {
+  auto const total = static_cast<std::size_t>(iterations_);
+  if (steps_ < total && cache_) {
+    orbit_ = cache_->orbit(parameters_, physical_state());
+    if (orbit_) jump(total);
+  }
+  if (steps_ < total && closure_tolerance_ > 0) {
+    fast_forward(total);
+  } else if (steps_ < total) {
+    Outcome const outcome = evolve_n(total - steps_);
+    if (outcome.status != Status::Completed) {
+      std::cerr << message(outcome.status);
+    }
+  }
+  flush();
+}
+
+// FLUSH()
+template <typename Integrator>
+void BasicSimulation<Integrator>::flush() {
+  close_window();
+  sink_->flush();
+}
 
-  if ((x_rel_new <= 0) || (y_rel_new <= 0)) {
-    throw std::runtime_error("\nSIMULATION'S OVER: ECOSYSTEM WENT EXTINCT. \n");
+// EVOLUTION()
+template <typename Integrator>
+std::vector<State> const& BasicSimulation<Integrator>::evolution() const {
+  auto const* memory = memory_of(*sink_);
+  if (memory == nullptr) {
+    throw std::logic_error("The evolution is not kept in memory.");
   }
+  return memory->data();
+}
 
-  auto x_new = x_rel_new * parameters_.d / parameters_.c;
-  auto y_new = y_rel_new * parameters_.a / parameters_.b;
+// SET_SINK()
+template <typename Integrator>
+void BasicSimulation<Integrator>::set_sink(
+    std::shared_ptr<Sink<State>> sink) {
+  if (!sink) throw std::invalid_argument("Invalid input.");
+  close_window();
+  if constexpr (adaptive_v<Integrator>) sink->stamp_time();
+  sink_ = std::move(sink);
+  sink_->push(current_);
+}
 
-  auto H_new = (parameters_.c * x_new) + (parameters_.b * y_new) -
-               (parameters_.d * std::log(x_new)) -
-               (parameters_.a * std::log(y_new));
+// SET_ANALYZER()
+template <typename Integrator>
+void BasicSimulation<Integrator>::set_analyzer(
+    std::shared_ptr<OrbitAnalyzer> analyzer) {
+  analyzer_ = std::move(analyzer);
+  if (analyzer_) analyzer_->observe(physical_state());
+}
 
-  state_ = State{x_rel_new, y_rel_new, H_new};
+// SET_FAST_FORWARD()
+template <typename Integrator>
+void BasicSimulation<Integrator>::set_fast_forward(double tolerance) {
+  if (adaptive_v<Integrator>)
+    throw std::logic_error("Fast forward needs a fixed time step.");
+  if (!(tolerance > 0) || !std::isfinite(tolerance))
+    throw std::invalid_argument("Invalid input.");
+  closure_tolerance_ = tolerance;
+}
 
-  evolution_.push_back(State{x_new, y_new, H_new});
+// SET_END_TIME()
+template <typename Integrator>
+void BasicSimulation<Integrator>::set_end_time(double t) {
+  if (!adaptive_v<Integrator>)
+    throw std::logic_error("The end time needs an adaptive scheme.");
+  if (!(t > state_.t) || !std::isfinite(t))
+    throw std::invalid_argument("Invalid input.");
+  end_time_ = t;
 }
 
-// GO()
-void Simulation::go() {
-  while (static_cast<double>(evolution_.size()) < iterations_) {
-    try {
-      this->evolve();
-    } catch (const std::runtime_error& error) {
-      std::cerr << error.what();
+// SET_CACHE()
+template <typename Integrator>
+void BasicSimulation<Integrator>::set_cache(std::shared_ptr<OrbitCache> cache) {
+  if (adaptive_v<Integrator>)
+    throw std::logic_error("The cache needs a fixed time step.");
+  cache_ = std::move(cache);
+}
+
+// STATE_AT()
+template <typename Integrator>
+State BasicSimulation<Integrator>::state_at(std::size_t step) const {
+  if (!orbit_) throw std::logic_error("The orbit has not been closed.");
+  return orbit_->at(static_cast<double>(step) * timescale_);
+}
+
+// SET_RECORDING()
+template <typename Integrator>
+void BasicSimulation<Integrator>::set_recording(Recording recording) {
+  if (recording.stride == 0 || recording.threshold < 0)
+    throw std::invalid_argument("Invalid input.");
+  close_window();
+  recording_ = recording;
+  window_.reset();
+  if (recording.window != 0) window_.emplace(recording.window);
+}
+
+// SAVE_EVOLUTION()
+template <typename Integrator>
+void BasicSimulation<Integrator>::save_evolution(
+    std::string const& filename) {
+  auto const& states = evolution();
+  if constexpr (adaptive_v<Integrator>) {
+    TextWriter writer{filename};
+    writer.write("t\tx\ty\tH\n");
+    for (std::size_t i{0}; i < states.size(); ++i) {
+      writer.row(i, Timed{states[i]});
+    }
+    writer.close();
+  } else {
+    write_text(filename, "x\ty\tH", std::span{states});
+  }
+}
+
+// SAVE_PLOT()
+template <typename Integrator>
+void BasicSimulation<Integrator>::save_plot(std::string const& filename) {
+  auto const& states = evolution();
+  auto t = [&](std::size_t i) { return states[i].t; };
+  PlotStyle style{"POPULATION", "TIME", "INDIVIDUALS"};
+  save_svg(filename, style,
+           {Series{"PREY", "#00ff00", states.size(), t,
+                   [&](std::size_t i) { return states[i].x; }},
+            Series{"PREDATORS", "#ffa500", states.size(), t,
+                   [&](std::size_t i) { return states[i].y; }}});
+}
+
+//--------------------------PRIVATE FUNCTIONS-----------------------
+
+// ADVANCE()
+// One step without exceptions, shared by evolve() and evolve_n(). The
+// physical state is computed only when it is recorded, analyzed or asked
+// for through physical.
+template <typename Integrator>
+Status BasicSimulation<Integrator>::advance(State* physical) {
+  auto x_rel_new = state_.x;
+  auto y_rel_new = state_.y;
+
+  double dt{};
+  double left{};  // time left before end_time_
+  if constexpr (adaptive_v<Integrator>) {
+    left = end_time_ - state_.t;
+    dt = integrator_.step(x_rel_new, y_rel_new, parameters_.a, parameters_.d,
+                          timescale_, left);
+  } else {
+    dt = integrator_.step(x_rel_new, y_rel_new, parameters_.a, parameters_.d,
+                          timescale_);
+  }
+  if (!(dt > 0)) return stop(Status::StepUnderflow);
+
+  // in logarithmic coordinates only an overflow can break positivity
+  bool const extinct = logarithmic_v<Integrator>
+                           ? !std::isfinite(x_rel_new) ||
+                                 !std::isfinite(y_rel_new)
+                           : (x_rel_new <= 0) || (y_rel_new <= 0);
+  if (extinct) return stop(Status::Extinct);
+
+  state_.x = x_rel_new;
+  state_.y = y_rel_new;
+  state_.t = dt == left ? end_time_ : state_.t + dt;
+  ++steps_;
+
+  bool const recorded = is_recorded();
+  if (recorded || analyzer_ || physical != nullptr) {
+    State const state = physical_state();
+    if (recorded) record(state);
+    if (analyzer_) analyzer_->observe(state);
+    if (physical != nullptr) *physical = state;
+  }
+  return Status::Completed;
+}
+
+// FAST_FORWARD()
+template <typename Integrator>
+void BasicSimulation<Integrator>::fast_forward(std::size_t total) {
+  double const section = parameters_.d / parameters_.c;
+  std::vector<State> samples{physical_state()};
+  bool crossed{false};
+  double first_crossing{};
+  double first_H{};
+
+  while (steps_ < total) {
+    State state{};
+    Status const status = advance(&state);
+    if (status != Status::Completed) {
+      std::cerr << message(status);
+      return;
+    }
+
+    State const previous = samples.back();
+    samples.push_back(state);
+    if (previous.x >= section || state.x < section) continue;
+
+    // upward crossing of the section, time and H interpolated
+    double const w = (section - previous.x) / (state.x - previous.x);
+    double const crossing = previous.t + w * (state.t - previous.t);
+    double const H = previous.H + w * (state.H - previous.H);
+
+    if (crossed && std::abs(H - first_H) <=
+                       closure_tolerance_ * std::max(1., std::abs(first_H))) {
+      orbit_ = std::make_shared<PeriodicOrbit const>(
+          std::move(samples), first_crossing, crossing - first_crossing);
       break;
     }
+
+    // not closed yet: restart the period from this crossing
+    crossed = true;
+    first_crossing = crossing;
+    first_H = H;
+    samples.erase(samples.begin(), samples.end() - 2);
   }
+
+  if (orbit_) jump(total);
 }
 
-// SAVE_EVOLUTION()
-void Simulation::save_evolution() {
-  std::ofstream outfile{"EVOLUTION.csv"};
-  outfile << "x\ty\tH\n";
-  for (auto const& state : evolution_) {
-    outfile << state.x << '\t' << state.y << '\t' << state.H << '\n';
+// JUMP()
+// Moves to the last step, taking its state from orbit_.
+template <typename Integrator>
+void BasicSimulation<Integrator>::jump(std::size_t total) {
+  if (steps_ >= total) return;
+
+  double const t_final =
+      state_.t + static_cast<double>(total - steps_) * timescale_;
+  State const final_state = orbit_->at(t_final);
+  set_internal_state(final_state);
+  steps_ = total;
+  record(final_state);
+}
+
+// SET_INTERNAL_STATE()
+template <typename Integrator>
+void BasicSimulation<Integrator>::set_internal_state(State const& physical) {
+  state_.x = physical.x * parameters_.c / parameters_.d;
+  state_.y = physical.y * parameters_.b / parameters_.a;
+  if constexpr (logarithmic_v<Integrator>) {
+    state_.x = std::log(state_.x);
+    state_.y = std::log(state_.y);
   }
+  state_.H = physical.H;
+  state_.t = physical.t;
 }
 
-// SAVE_PLOT()
-void Simulation::save_plot() {
-  std::ofstream data_file{".tmp.csv"};
-  double t{0};
+// IS_RECORDED()
+template <typename Integrator>
+bool BasicSimulation<Integrator>::is_recorded() const {
+  std::size_t const step = steps_ - 1;
+  if (static_cast<double>(steps_) == iterations_ || state_.t == end_time_)
+    return true;
+
+  if (step % recording_.stride != 0) return false;
 
-  for (auto const& state : evolution_) {
-    data_file << t << '\t' << state.x << '\t' << state.y << '\t' << state.H << '\n';
-    t += timescale_;
+  // the relative change is the same in relative and physical coordinates
+  if (recording_.threshold > 0) {
+    double change_x{};
+    double change_y{};
+    if constexpr (logarithmic_v<Integrator>) {
+      change_x = std::abs(std::expm1(state_.x - recorded_.x));
+      change_y = std::abs(std::expm1(state_.y - recorded_.y));
+    } else {
+      change_x = std::abs(state_.x - recorded_.x) / recorded_.x;
+      change_y = std::abs(state_.y - recorded_.y) / recorded_.y;
+    }
+    if (change_x <= recording_.threshold && change_y <= recording_.threshold)
+      return false;
   }
 
-  data_file.close();
+  return true;
+}
 
-  std::ofstream gp_script{".tmp.gp"};
-  gp_script
-      << "set terminal svg size 1000,600 font 'Arial,14' background '#99d6e1'\n"
-      << "set output 'PLOT.svg'\n"
-      << "set title 'POPULATION'\n"
-      << "set xlabel 'TIME'\n"
-      << "set ylabel 'INDIVIDUALS'\n"
-      << "set xrange [0:" << t << "]\n"
-      << "set autoscale y\n"
-      << "set grid\n"
-      << "plot '.tmp.csv' using 1:2 with lines lw 2 lc rgb 'green' title "
-         "'PREY', "
-      << "'.tmp.csv' using 1:3 with lines lw 2 lc rgb 'orange' title "
-         "'PREDATORS'\n";
+// PHYSICAL_STATE()
+// Physical coordinates and Hamiltonian of the internal state.
+template <typename Integrator>
+State BasicSimulation<Integrator>::physical_state() const {
+  double H_new{};
+  double x_new{};
+  double y_new{};
 
-  gp_script.close();
+  if constexpr (logarithmic_v<Integrator>) {
+    // H = c x + b y - d log x - a log y, with log x = u + log(d/c)
+    double const x_rel = std::exp(state_.x);
+    double const y_rel = std::exp(state_.y);
+    x_new = x_rel * parameters_.d / parameters_.c;
+    y_new = y_rel * parameters_.a / parameters_.b;
+    H_new = parameters_.d * (x_rel - state_.x) +
+            parameters_.a * (y_rel - state_.y) - log_offset_;
+  } else {
+    x_new = state_.x * parameters_.d / parameters_.c;
+    y_new = state_.y * parameters_.a / parameters_.b;
+    H_new = (parameters_.c * x_new) + (parameters_.b * y_new) -
+            (parameters_.d * std::log(x_new)) -
+            (parameters_.a * std::log(y_new));
+  }
+
+  return State{x_new, y_new, H_new, state_.t};
+}
 
-  int check = std::system("gnuplot .tmp.gp");
-  if (check != 0) {
-    std::cerr << "gnuplot failed\n";
+// RECORD()
+template <typename Integrator>
+void BasicSimulation<Integrator>::record(State const& state) {
+  state_.H = state.H;
+  recorded_ = state_;
+  recorded_steps_ = steps_;
+  current_ = state;
+
+  if (window_) {
+    window_->push(current_);
+  } else {
+    sink_->push(current_);
   }
-  std::remove(".tmp.gp");
-  std::remove(".tmp.csv");
+}
 
-  std::cout << "\nPlot and temporal evolution of the simulation saved.\n";
+// STOP()
+// A failed step leaves the state untouched: the last valid one is recorded
+// if it was not, and the window is emptied into the sink.
+template <typename Integrator>
+Status BasicSimulation<Integrator>::stop(Status status) {
+  if (recorded_steps_ != steps_) record(physical_state());
+  close_window();
+  return status;
 }
 
+// CLOSE_WINDOW()
+template <typename Integrator>
+void BasicSimulation<Integrator>::close_window() {
+  if (!window_) return;
+  for (std::size_t i{0}; i < window_->size(); ++i) sink_->push((*window_)[i]);
+  window_->clear();
+}
+
+// shipped integration schemes
+template class BasicSimulation<SymplecticEuler>;
+template class BasicSimulation<StormerVerlet>;
+template class BasicSimulation<Yoshida4>;
+template class BasicSimulation<Yoshida6>;
+template class BasicSimulation<Yoshida8>;
+template class BasicSimulation<DormandPrince>;
+template class BasicSimulation<LogStormerVerlet>;
+template class BasicSimulation<LogYoshida4>;
+template class BasicSimulation<LogYoshida6>;
+template class BasicSimulation<LogYoshida8>;
+
 //--------------------EXTERNAL FUNCTIONS------------------------
 
 // OPERATOR== PARAMETERS
@@ -127,6 +427,58 @@ bool operator==(State const& example1, State const& example2) {
   return example1.x == example2.x && example1.y == example2.y;
 }
 
+// WRITE_ROW STATES
+void write_row(std::ostream& out, std::size_t row, State const& state) {
+  char line[TextWriter::max_row];
+  out.write(line, format_row(line, row, state) - line);
+}
+
+// FORMAT_ROW
+char* format_row(char* out, std::size_t, State const& state) {
+  out = to_text(out, state.x);
+  *out++ = '\t';
+  out = to_text(out, state.y);
+  *out++ = '\t';
+  out = to_text(out, state.H);
+  *out++ = '\n';
+  return out;
+}
+
+// WRITE_ROW TIMED
+void write_row(std::ostream& out, std::size_t row,
+               Timed<State> const& timed) {
+  char line[TextWriter::max_row];
+  out.write(line, format_row(line, row, timed) - line);
+}
+
+// FORMAT_ROW TIMED
+char* format_row(char* out, std::size_t row,
+                 Timed<State> const& timed) {
+  out = to_text(out, timed.value.t);
+  *out++ = '\t';
+  return format_row(out, row, timed.value);
+}
+
+// MESSAGE
+std::string message(Status status) {
+  switch (status) {
+    case Status::Extinct:
+      return "\nSIMULATION'S OVER: ECOSYSTEM WENT EXTINCT. \n";
+    case Status::StepUnderflow:
+      return "\nSIMULATION'S OVER: STEP SIZE UNDERFLOW. \n";
+    case Status::Completed:
+      break;
+  }
+  return "\nSIMULATION COMPLETED. \n";
+}
+
+// VALIDATE()
+void validate(Parameters const& p, double x, double y, double dt, double it) {
+  if (it <= 0.0 || std::floor(it) != it || x <= 0 || y <= 0 || dt <= 0 ||
+      p.a <= 0 || p.b <= 0 || p.c <= 0 || p.d <= 0)
+    throw std::invalid_argument("Invalid input.");
+}
+
 // SAFE INPUT FUNCTION
 double control(const std::string& message) {
   double input;
@@ -4,12 +4,23 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "integrators.hpp"
+#include "outcome.hpp"
+#include "sink.hpp"
+
 namespace volterra {
 
+class OrbitAnalyzer;
+class OrbitCache;
+class PeriodicOrbit;
+
 // --------------------------- STRUCT ---------------------------
 
 struct Parameters {
@@ -23,47 +34,158 @@ struct State {
   double x;  // prey
   double y;  // predator
   double H;  // Hamiltonian
+  double t{0.};  // time
+};
+
+// Which steps reach the sink. A step is recorded when the stride and the
+// threshold accept it; the initial state, the last step of go() and the
+// last state before a failed step (extinction, step underflow) are always
+// recorded. With a window, recorded states wait in a trailing buffer and
+// only the last window of them reach the sink, when go() returns, a step
+// fails, the sink or the recording changes, or flush() is called. A run
+// driven in chunks by evolve_n() thus keeps the last window of the whole
+// run, provided it calls flush() at the end.
+// Unrecorded steps skip the physical coordinates and the Hamiltonian.
+struct Recording {
+  std::size_t stride{1};  // record one step out of stride
+  std::size_t window{0};  // keep only the last window recorded states
+                          // (0 = all)
+  double threshold{0.};   // record only when x or y changed by more than
+                          // this fraction since the last recorded state
 };
 
 // --------------------------- CLASS ---------------------------
 
-class Simulation {
+// The integration scheme is a policy (see integrators.hpp). The shipped
+// schemes are instantiated in simulation.cpp.
+template <typename Integrator>
+class BasicSimulation {
   // attributes
+  Integrator integrator_;
   Parameters const parameters_;
   double const timescale_;
   double const iterations_;
   State state_;
-  std::vector<State> evolution_;
+  State initial_;  // physical coordinates
+  State current_;  // physical coordinates
+  std::size_t steps_;  // states produced, the initial one included
+  std::shared_ptr<Sink<State>> sink_;
+  Recording recording_;
+  std::optional<RingSink<State>> window_;  // only with recording_.window
+  State recorded_;  // internal state at the last recorded step
+  std::size_t recorded_steps_{1};  // steps_ at the last recorded step
+  double log_offset_;  // d log(d/c) + a log(a/b), for logarithmic schemes
+
+  std::shared_ptr<OrbitAnalyzer> analyzer_;
+  double end_time_{std::numeric_limits<double>::infinity()};
+  double closure_tolerance_{0.};  // 0 = fast forward disabled
+  std::shared_ptr<PeriodicOrbit const> orbit_;
+  std::shared_ptr<OrbitCache> cache_;
+
+  Status advance(State* physical = nullptr);
+  void fast_forward(std::size_t total);
+  void jump(std::size_t total);
+  void set_internal_state(State const& physical);
+  bool is_recorded() const;
+  State physical_state() const;
+  void record(State const& state);
+  Status stop(Status status);
+  void close_window();
 
  public:
   //-------------------------CONSTRUCTOR------------------------------
-  Simulation(Parameters p_, double x_, double y_, double dt_, double it_);
+  // with an adaptive integrator dt_ is only the initial step
+  BasicSimulation(Parameters p_, double x_, double y_, double dt_, double it_,
+                  Integrator integrator_ = Integrator{});
 
   //-----------------------PUBLIC FUNCTIONS-------------------------
   // getters
   Parameters const& parameters() const { return parameters_; }
-  State const& initial_state() const { return evolution_.front(); }
-  State const& current_state() const { return evolution_.back(); }
+  Integrator const& integrator() const { return integrator_; }
+  // current_state() and internal_state().H refer to the last recorded step;
+  // for the logarithmic schemes internal_state() holds the logarithms of
+  // the relative coordinates
+  State const& initial_state() const { return initial_; }
+  State const& current_state() const { return current_; }
   State const& internal_state() const { return state_; }
   double timescale() const { return timescale_; }
   double iterations() const { return iterations_; }
-  std::vector<State> const& evolution() const { return evolution_; }
+  std::size_t steps() const { return steps_; }
+  std::vector<State> const& evolution() const;
+
+  // output of the states, by default kept in memory (see evolution())
+  // the new sink receives the current state first, then every later one;
+  // with an adaptive scheme it is asked to stamp the time (see Sink)
+  void set_sink(std::shared_ptr<Sink<State>> sink);
+  Sink<State>& sink() const { return *sink_; }
+
+  void set_recording(Recording recording);
+  Recording const& recording() const { return recording_; }
+
+  // Adaptive schemes only: go() and evolve_n() stop when the time reaches
+  // t, the last step being shortened to end exactly there. iterations()
+  // stays a bound on the number of steps.
+  void set_end_time(double t);
+  double end_time() const { return end_time_; }
+
+  // online analysis of every step, recorded or not (nullptr detaches it)
+  void set_analyzer(std::shared_ptr<OrbitAnalyzer> analyzer);
+  OrbitAnalyzer const* analyzer() const { return analyzer_.get(); }
+
+  // Fast forward (fixed-step schemes only): go() integrates until the orbit
+  // closes, i.e. two upward crossings of x = d/c with H matching within
+  // tolerance (relative), then jumps to the last step and answers any other
+  // step from the stored period. The sink only sees the integrated steps
+  // and the final one, the analyzer only the integrated steps (not the
+  // final state). The tolerance must be positive.
+  void set_fast_forward(double tolerance);
+  PeriodicOrbit const* orbit() const { return orbit_.get(); }
+  State state_at(std::size_t step) const;
+
+  // With a cache (fixed-step schemes only), go() takes the orbit from it,
+  // integrating only the canonical orbits not seen yet, then behaves as
+  // after a fast forward. The states follow the exact orbit, not the
+  // discretization error of the scheme.
+  void set_cache(std::shared_ptr<OrbitCache> cache);
 
   // calculations
+  // evolve() throws when the ecosystem goes extinct, evolve_n() reports it
   void evolve();
+  Outcome evolve_n(std::size_t count);
   void go();
+  // empties the window into the sink and flushes the sink, as go() does
+  void flush();
 
   // file and output
-  void save_evolution();
-  void save_plot();
+  void save_evolution(std::string const& filename = "EVOLUTION.csv");
+  void save_plot(std::string const& filename = "PLOT.svg");
 };
 
+using Simulation = BasicSimulation<SymplecticEuler>;
+using AdaptiveSimulation = BasicSimulation<DormandPrince>;
+
 //--------------------EXTERNAL FUNCTIONS------------------------
 
 // operators
 bool operator==(Parameters const& example1, Parameters const& example2);
 bool operator==(State const& example1, State const& example2);
 
+// one line of EVOLUTION.csv, used by save_evolution() and FileSink<State>
+void write_row(std::ostream& out, std::size_t row, State const& state);
+// the same line after the time stamp, for the adaptive schemes
+void write_row(std::ostream& out, std::size_t row,
+               Timed<State> const& timed);
+// the same line written at out (see TextWriter), returns its end
+char* format_row(char* out, std::size_t row, State const& state);
+// the same line after the time stamp, for the adaptive schemes
+char* format_row(char* out, std::size_t row, Timed<State> const& timed);
+
+// text printed by go() when a run stops early
+std::string message(Status status);
+
+// throws std::invalid_argument if the constructor would reject the input
+void validate(Parameters const& p, double x, double y, double dt, double it);
+
 // control function
 double control(const std::string&);
 
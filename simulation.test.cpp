@@ -1,8 +1,12 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 
 #include "simulation.hpp"
+#include "async_sink.hpp"
+
+#include <cstdio>
 
 #include "doctest.h"
+#include "test_files.hpp"
 
 TEST_CASE("Testing constructor") {
   SUBCASE(" a=0 ") {
@@ -132,3 +136,490 @@ TEST_CASE("Testing methods") {
     }
   }
 }
+
+TEST_CASE("Testing sinks") {
+  volterra::Simulation sim({400., 1., 1., 500.}, 1000., 1000., 0.0001, 10.);
+
+  SUBCASE("RingSink keeps only the last states") {
+    auto ring = std::make_shared<volterra::RingSink<volterra::State>>(3);
+    sim.set_sink(ring);
+    sim.go();
+
+    CHECK(sim.steps() == std::size_t(10));
+    CHECK(ring->total() == std::size_t(10));
+    REQUIRE(ring->size() == std::size_t(3));
+    CHECK((*ring)[2] == sim.current_state());
+    CHECK(sim.initial_state() == volterra::State{1000., 1000., 0.});
+    CHECK_THROWS_AS(sim.evolution(), std::logic_error);
+  }
+
+  SUBCASE("CallbackSink receives every state") {
+    volterra::Simulation reference({400., 1., 1., 500.}, 1000., 1000., 0.0001,
+                                   10.);
+    reference.go();
+
+    std::vector<volterra::State> received;
+    sim.set_sink(std::make_shared<volterra::CallbackSink<volterra::State>>(
+        [&received](volterra::State const& s) { received.push_back(s); }));
+    sim.go();
+
+    REQUIRE(received.size() == reference.evolution().size());
+    for (std::size_t i{0}; i < received.size(); ++i) {
+      CHECK(received[i] == reference.evolution()[i]);
+      CHECK(received[i].H == reference.evolution()[i].H);
+    }
+  }
+
+  SUBCASE("FileSink writes the same rows as save_evolution()") {
+    std::string const streamed = temporary("volterra_sink_streamed.csv");
+    std::string const expected = temporary("volterra_sink_expected.csv");
+    sim.set_sink(std::make_shared<volterra::FileSink<volterra::State>>(
+        streamed, "x\ty\tH"));
+    sim.go();
+    sim.sink().flush();
+
+    volterra::Simulation reference({400., 1., 1., 500.}, 1000., 1000.,
+                                   0.0001, 10.);
+    reference.go();
+    reference.save_evolution(expected);
+
+    CHECK(read_file(streamed).starts_with("x\ty\tH\n"));
+    CHECK(read_file(streamed) == read_file(expected));
+    std::remove(streamed.c_str());
+    std::remove(expected.c_str());
+  }
+
+  SUBCASE("set_sink() with a null sink throws") {
+    CHECK_THROWS_AS(sim.set_sink(nullptr), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Testing recording policies") {
+  volterra::Simulation reference({400., 1., 1., 500.}, 1000., 1000., 0.0001,
+                                 20.);
+  reference.go();
+  auto const& all = reference.evolution();
+
+  volterra::Simulation sim({400., 1., 1., 500.}, 1000., 1000., 0.0001, 20.);
+
+  SUBCASE("stride") {
+    sim.set_recording({6, 0, 0.});
+    sim.go();
+
+    // steps 0, 6, 12, 18 and the last one (19)
+    auto const& evolution = sim.evolution();
+    REQUIRE(evolution.size() == std::size_t(5));
+    CHECK(evolution[1] == all[6]);
+    CHECK(evolution[3] == all[18]);
+    CHECK(evolution[4] == all[19]);
+    CHECK(evolution[4].H == doctest::Approx(all[19].H).epsilon(1e-12));
+    CHECK(sim.current_state() == all.back());
+    CHECK(sim.steps() == std::size_t(20));
+  }
+
+  SUBCASE("window") {
+    sim.set_recording({1, 4, 0.});
+    sim.go();
+
+    // initial state plus the last 4 steps
+    auto const& evolution = sim.evolution();
+    REQUIRE(evolution.size() == std::size_t(5));
+    CHECK(evolution[0] == all[0]);
+    for (std::size_t i{1}; i < 5; ++i) CHECK(evolution[i] == all[15 + i]);
+  }
+
+  SUBCASE("window over a run driven in chunks") {
+    volterra::Simulation chunked({400., 1., 1., 500.}, 1000., 1000., 0.00001,
+                                 1001.);
+    chunked.set_recording({1, 4, 0.});
+    for (int i{0}; i < 10; ++i) chunked.evolve_n(100);
+    CHECK(chunked.evolution().size() == std::size_t(1));
+    chunked.flush();
+
+    volterra::Simulation whole({400., 1., 1., 500.}, 1000., 1000., 0.00001,
+                               1001.);
+    whole.go();
+    auto const& steps = whole.evolution();
+
+    // initial state plus the last 4 of the 1000 steps
+    auto const& evolution = chunked.evolution();
+    REQUIRE(evolution.size() == std::size_t(5));
+    CHECK(evolution[0] == steps[0]);
+    for (std::size_t i{1}; i < 5; ++i) CHECK(evolution[i] == steps[996 + i]);
+  }
+
+  SUBCASE("the window goes to the sink it was recorded for") {
+    auto first = std::make_shared<volterra::VectorSink<volterra::State>>();
+    auto second = std::make_shared<volterra::VectorSink<volterra::State>>();
+    sim.set_sink(first);
+    sim.set_recording({1, 4, 0.});
+    sim.evolve_n(10);
+    sim.set_sink(second);
+    sim.evolve_n(3);
+    sim.flush();
+
+    // initial state plus steps 7 to 10, then step 10 again and 11 to 13
+    REQUIRE(first->data().size() == std::size_t(5));
+    CHECK(first->data()[0] == all[0]);
+    CHECK(first->data()[4] == all[10]);
+    REQUIRE(second->data().size() == std::size_t(4));
+    CHECK(second->data()[0] == all[10]);
+    CHECK(second->data()[3] == all[13]);
+  }
+
+  SUBCASE("a run that stops early keeps its last states") {
+    // goes extinct well before the 50 steps of go()
+    volterra::Simulation full({400., 1., 1., 500.}, 1000., 1000., 0.0009, 50.);
+    full.go();
+    auto const& steps = full.evolution();
+    REQUIRE(steps.size() < std::size_t(40));
+
+    volterra::Simulation windowed({400., 1., 1., 500.}, 1000., 1000., 0.0009,
+                                  50.);
+    windowed.set_recording({1, 3, 0.});
+    windowed.go();
+    auto const& evolution = windowed.evolution();
+    REQUIRE(evolution.size() == std::size_t(4));
+    for (std::size_t i{1}; i < 4; ++i) {
+      CHECK(evolution[i] == steps[steps.size() - 4 + i]);
+    }
+    CHECK(windowed.current_state() == steps.back());
+
+    volterra::Simulation strided({400., 1., 1., 500.}, 1000., 1000., 0.0009,
+                                 50.);
+    strided.set_recording({1000, 0, 0.});
+    strided.go();
+    REQUIRE(strided.evolution().size() == std::size_t(2));
+    CHECK(strided.evolution().back() == steps.back());
+    CHECK(strided.evolution().back().H == steps.back().H);
+    CHECK(strided.current_state() == steps.back());
+  }
+
+  SUBCASE("threshold") {
+    sim.set_recording({1, 0, 0.1});
+    sim.go();
+
+    auto const& evolution = sim.evolution();
+    REQUIRE(evolution.size() > std::size_t(2));
+    CHECK(evolution.size() < all.size());
+    for (std::size_t i{1}; i + 1 < evolution.size(); ++i) {
+      bool const x_changed =
+          std::abs(evolution[i].x - evolution[i - 1].x) >
+          0.1 * evolution[i - 1].x;
+      bool const y_changed =
+          std::abs(evolution[i].y - evolution[i - 1].y) >
+          0.1 * evolution[i - 1].y;
+      CHECK((x_changed || y_changed));
+    }
+    CHECK(evolution.back() == all.back());
+  }
+
+  SUBCASE("invalid policies throw") {
+    CHECK_THROWS_AS(sim.set_recording({0, 0, 0.}), std::invalid_argument);
+    CHECK_THROWS_AS(sim.set_recording({1, 0, -1.}), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Testing integrators") {
+  volterra::Parameters const p{1.3, 0.5, 0.2, 0.8};
+
+  // maximum |H - H0| over a run of about 15 periods
+  auto drift = [](auto sim) {
+    sim.go();
+    double max{0.};
+    for (auto const& state : sim.evolution()) {
+      max = std::max(max, std::abs(state.H - sim.initial_state().H));
+    }
+    return max;
+  };
+
+  SUBCASE("default scheme is unchanged") {
+    volterra::BasicSimulation<volterra::SymplecticEuler> explicit_sim(
+        {400., 1., 1., 500.}, 1000., 1000., 0.0001, 3.);
+    volterra::Simulation sim({400., 1., 1., 500.}, 1000., 1000., 0.0001, 3.);
+    explicit_sim.go();
+    sim.go();
+    CHECK(explicit_sim.evolution()[2] == sim.evolution()[2]);
+  }
+
+  SUBCASE("higher orders keep H with much larger steps") {
+    double const euler =
+        drift(volterra::Simulation(p, 10., 4., 0.001, 100000.));
+    double const verlet = drift(
+        volterra::BasicSimulation<volterra::StormerVerlet>(p, 10., 4., 0.01,
+                                                           10000.));
+    double const yoshida4 = drift(
+        volterra::BasicSimulation<volterra::Yoshida4>(p, 10., 4., 0.05,
+                                                      2000.));
+    double const yoshida6 = drift(
+        volterra::BasicSimulation<volterra::Yoshida6>(p, 10., 4., 0.1,
+                                                      1000.));
+    double const yoshida8 = drift(
+        volterra::BasicSimulation<volterra::Yoshida8>(p, 10., 4., 0.1,
+                                                      1000.));
+
+    CHECK(verlet < euler);
+    CHECK(yoshida4 < euler);
+    CHECK(yoshida6 < euler);
+    CHECK(yoshida8 < euler);
+    CHECK(yoshida8 < yoshida6);
+  }
+
+  SUBCASE("schemes converge with their order") {
+    // x after t = 4, compared with a fine Yoshida8 solution
+    auto final_x = [&p](auto sim) {
+      sim.go();
+      return sim.current_state().x;
+    };
+    double const reference = final_x(
+        volterra::BasicSimulation<volterra::Yoshida8>(p, 10., 4., 0.001,
+                                                      4001.));
+    auto ratio = [&](auto coarse, auto fine) {
+      return std::abs(final_x(coarse) - reference) /
+             std::abs(final_x(fine) - reference);
+    };
+
+    using Verlet = volterra::BasicSimulation<volterra::StormerVerlet>;
+    using Y4 = volterra::BasicSimulation<volterra::Yoshida4>;
+    using Y6 = volterra::BasicSimulation<volterra::Yoshida6>;
+    CHECK(ratio(Verlet(p, 10., 4., 0.1, 41.), Verlet(p, 10., 4., 0.05, 81.)) ==
+          doctest::Approx(4.).epsilon(0.05));
+    CHECK(ratio(Y4(p, 10., 4., 0.1, 41.), Y4(p, 10., 4., 0.05, 81.)) ==
+          doctest::Approx(16.).epsilon(0.05));
+    CHECK(ratio(Y6(p, 10., 4., 0.1, 41.), Y6(p, 10., 4., 0.05, 81.)) ==
+          doctest::Approx(64.).epsilon(0.05));
+  }
+}
+
+TEST_CASE("Testing adaptive integration") {
+  volterra::Parameters const p{1.3, 0.5, 0.2, 0.8};
+
+  SUBCASE("invalid tolerance throws") {
+    CHECK_THROWS_AS(volterra::DormandPrince(0.), std::invalid_argument);
+    CHECK_THROWS_AS(volterra::DormandPrince(-1e-6), std::invalid_argument);
+  }
+
+  SUBCASE("time stamps follow the accepted steps") {
+    volterra::AdaptiveSimulation sim(p, 10., 4., 0.01, 500.,
+                                     volterra::DormandPrince{1e-10});
+    sim.go();
+
+    auto const& evolution = sim.evolution();
+    REQUIRE(evolution.size() == std::size_t(500));
+    CHECK(evolution.front().t == 0.);
+    bool increasing{true};
+    bool uniform{true};
+    double const first_dt = evolution[1].t - evolution[0].t;
+    for (std::size_t i{1}; i < evolution.size(); ++i) {
+      double const dt = evolution[i].t - evolution[i - 1].t;
+      increasing = increasing && dt > 0;
+      uniform = uniform && std::abs(dt - first_dt) < 1e-12;
+    }
+    CHECK(increasing);
+    CHECK_FALSE(uniform);
+    CHECK(sim.current_state().t == evolution.back().t);
+    CHECK(sim.integrator().accepted() == std::size_t(499));
+
+    double max{0.};
+    for (auto const& state : evolution) {
+      max = std::max(max, std::abs(state.H - sim.initial_state().H));
+    }
+    CHECK(max < 1e-6);
+  }
+
+  SUBCASE("fixed-step time stamps are multiples of dt") {
+    volterra::Simulation sim({400., 1., 1., 500.}, 1000., 1000., 0.0001, 3.);
+    sim.go();
+    CHECK(sim.evolution()[2].t == doctest::Approx(0.0002));
+  }
+
+  SUBCASE("deep population crash does not go extinct") {
+    // prey fall to about 1e-9 of their peak during each period
+    volterra::Parameters const crash{1., 1., 1., 1.};
+    volterra::AdaptiveSimulation sim(crash, 30., 1., 0.01, 2000.,
+                                     volterra::DormandPrince{1e-9});
+    sim.go();
+
+    CHECK(sim.steps() == std::size_t(2000));
+    double min_x{sim.initial_state().x};
+    for (auto const& state : sim.evolution()) {
+      min_x = std::min(min_x, state.x);
+    }
+    CHECK(min_x > 0);
+    CHECK(sim.current_state().t > 20.);
+  }
+
+  SUBCASE("runs stop at the end time") {
+    volterra::AdaptiveSimulation sim(p, 10., 4., 0.01, 100000.,
+                                     volterra::DormandPrince{1e-10});
+    sim.set_end_time(7.3);
+    sim.go();
+
+    CHECK(sim.current_state().t == 7.3);
+    CHECK(sim.evolution().back().t == 7.3);
+    CHECK(sim.steps() < std::size_t(100000));
+    // the shortened last step leaves the step size alone
+    CHECK(sim.integrator().next_step() > 7.3 / double(sim.steps()) / 10.);
+
+    CHECK_THROWS_AS(sim.set_end_time(7.3), std::invalid_argument);
+    CHECK_THROWS_AS(sim.set_end_time(HUGE_VAL), std::invalid_argument);
+    volterra::Simulation fixed(p, 10., 4., 0.01, 100.);
+    CHECK_THROWS_AS(fixed.set_end_time(1.), std::logic_error);
+  }
+
+  SUBCASE("EVOLUTION.csv has a time column") {
+    volterra::AdaptiveSimulation sim(p, 10., 4., 0.01, 20.);
+    sim.go();
+    std::string const filename = temporary("volterra_adaptive.csv");
+    sim.save_evolution(filename);
+
+    std::ifstream in{filename};
+    std::string line;
+    std::getline(in, line);
+    CHECK(line == "t\tx\ty\tH");
+    for (auto const& state : sim.evolution()) {
+      double t, x, y, H;
+      in >> t >> x >> y >> H;
+      CHECK(t == state.t);
+      CHECK(x == state.x);
+    }
+    std::remove(filename.c_str());
+  }
+
+  SUBCASE("a FileSink streams the time column too") {
+    std::string const streamed = temporary("volterra_adaptive_streamed.csv");
+    std::string const expected = temporary("volterra_adaptive_expected.csv");
+    volterra::AdaptiveSimulation sim(p, 10., 4., 0.01, 20.);
+    sim.set_sink(std::make_shared<volterra::AsyncSink<volterra::State>>(
+        std::make_shared<volterra::FileSink<volterra::State>>(streamed,
+                                                              "x\ty\tH")));
+    sim.go();
+
+    volterra::AdaptiveSimulation reference(p, 10., 4., 0.01, 20.);
+    reference.go();
+    reference.save_evolution(expected);
+
+    CHECK(read_file(streamed).starts_with("t\tx\ty\tH\n"));
+    CHECK(read_file(streamed) == read_file(expected));
+    std::remove(streamed.c_str());
+    std::remove(expected.c_str());
+  }
+}
+
+TEST_CASE("Testing logarithmic integrators") {
+  volterra::Parameters const p{1.3, 0.5, 0.2, 0.8};
+
+  SUBCASE("same orbit as the exact splitting in x, y") {
+    volterra::BasicSimulation<volterra::StormerVerlet> plain(p, 10., 4., 0.05,
+                                                             400.);
+    volterra::BasicSimulation<volterra::LogStormerVerlet> log(p, 10., 4., 0.05,
+                                                              400.);
+    plain.go();
+    log.go();
+
+    CHECK(log.internal_state().x ==
+          doctest::Approx(std::log(plain.internal_state().x)).epsilon(1e-9));
+    for (std::size_t i{0}; i < 400; i += 57) {
+      CHECK(log.evolution()[i].x ==
+            doctest::Approx(plain.evolution()[i].x).epsilon(1e-9));
+      CHECK(log.evolution()[i].y ==
+            doctest::Approx(plain.evolution()[i].y).epsilon(1e-9));
+      CHECK(log.evolution()[i].H ==
+            doctest::Approx(plain.evolution()[i].H).epsilon(1e-9));
+    }
+  }
+
+  SUBCASE("large steps do not go extinct") {
+    // the historical scheme dies within the first steps
+    volterra::Simulation euler({400., 1., 1., 500.}, 1000., 1000., 0.001, 50.);
+    euler.go();
+    CHECK(euler.steps() < std::size_t(50));
+
+    volterra::BasicSimulation<volterra::LogYoshida4> log(
+        {400., 1., 1., 500.}, 1000., 1000., 0.001, 50.);
+    log.go();
+    CHECK(log.steps() == std::size_t(50));
+    for (auto const& state : log.evolution()) {
+      CHECK(state.x > 0);
+      CHECK(state.y > 0);
+    }
+  }
+
+  SUBCASE("threshold recording uses the relative change") {
+    volterra::BasicSimulation<volterra::LogStormerVerlet> log(p, 10., 4.,
+                                                              0.01, 300.);
+    volterra::BasicSimulation<volterra::StormerVerlet> plain(p, 10., 4., 0.01,
+                                                             300.);
+    log.set_recording({1, 0, 0.05});
+    plain.set_recording({1, 0, 0.05});
+    log.go();
+    plain.go();
+    CHECK(log.evolution().size() == plain.evolution().size());
+  }
+}
+
+TEST_CASE("Testing evolve_n()") {
+  SUBCASE("completed run matches go()") {
+    volterra::Simulation reference({400., 1., 1., 500.}, 1000., 1000., 0.0001,
+                                   50.);
+    reference.go();
+
+    volterra::Simulation sim({400., 1., 1., 500.}, 1000., 1000., 0.0001, 50.);
+    auto const first = sim.evolve_n(20);
+    auto const second = sim.evolve_n(29);
+
+    CHECK(first.status == volterra::Status::Completed);
+    CHECK(first.step == std::size_t(20));
+    CHECK(second.status == volterra::Status::Completed);
+    CHECK(second.step == std::size_t(49));
+    CHECK(sim.evolution() == reference.evolution());
+  }
+
+  SUBCASE("extinction is reported, not thrown") {
+    volterra::Simulation sim({400., 1., 1., 500.}, 1000., 1000., 0.001, 50.);
+    volterra::Outcome outcome{};
+    CHECK_NOTHROW(outcome = sim.evolve_n(49));
+    CHECK(outcome.status == volterra::Status::Extinct);
+    CHECK(outcome.step == sim.steps() - 1);
+    CHECK(outcome.step < std::size_t(49));
+    CHECK_THROWS_AS(sim.evolve(), std::runtime_error);
+  }
+}
+
+TEST_CASE("Testing fast forward") {
+  volterra::Parameters const p{2., 1., 1., 0.5};
+  using LogSimulation = volterra::BasicSimulation<volterra::LogYoshida4>;
+
+  SUBCASE("invalid settings throw") {
+    volterra::AdaptiveSimulation adaptive(p, 1., 1., 0.01, 10.);
+    CHECK_THROWS_AS(adaptive.set_fast_forward(1e-6), std::logic_error);
+    LogSimulation sim(p, 1., 1., 0.01, 10.);
+    CHECK_THROWS_AS(sim.set_fast_forward(-1.), std::invalid_argument);
+    CHECK_THROWS_AS(sim.set_fast_forward(0.), std::invalid_argument);
+    CHECK_THROWS_AS(sim.set_fast_forward(std::nan("")), std::invalid_argument);
+    CHECK_THROWS_AS(sim.state_at(3), std::logic_error);
+  }
+
+  SUBCASE("later states come from the stored period") {
+    std::size_t const steps{20000};
+    LogSimulation reference(p, 1.5, 3., 0.01, static_cast<double>(steps));
+    reference.go();
+
+    LogSimulation sim(p, 1.5, 3., 0.01, 1e12);
+    sim.set_fast_forward(1e-8);
+    sim.go();
+
+    REQUIRE(sim.orbit() != nullptr);
+    CHECK(sim.steps() == std::size_t(1000000000000));
+    CHECK(sim.evolution().size() < std::size_t(2000));
+    CHECK(sim.current_state() == sim.evolution().back());
+
+    for (std::size_t step : {std::size_t(0), std::size_t(777), steps - 1}) {
+      auto const& expected = reference.evolution()[step];
+      auto const state = sim.state_at(step);
+      CHECK(state.x == doctest::Approx(expected.x).epsilon(1e-3));
+      CHECK(state.y == doctest::Approx(expected.y).epsilon(1e-3));
+      CHECK(state.t == doctest::Approx(expected.t));
+    }
+  }
+}
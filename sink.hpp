@@ -0,0 +1,183 @@
+#ifndef SINK_HPP
+#define SINK_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+// A value written with its time stamp, as in the EVOLUTION.csv of the
+// adaptive schemes (fixed-step files keep the x, y, H columns).
+template <typename T>
+struct Timed {
+  T const& value;
+};
+
+// --------------------------- CLASSES ---------------------------
+
+// Destination of the states produced by a simulation, one push() per
+// recorded step. Used by volterra::Simulation (T = State) and by
+// wator::GridSimulation (T = Population).
+template <typename T>
+class Sink {
+ public:
+  virtual ~Sink() = default;
+
+  virtual void push(T const& value) = 0;
+  virtual void flush() {}
+  // called before the first push() by the runs whose time step varies:
+  // file output then puts the time stamp of every value first
+  virtual void stamp_time() {}
+  // the sink every value is passed on to right away, if any
+  virtual Sink<T> const* forwards_to() const { return nullptr; }
+};
+
+// Keeps every value in memory (the historical behaviour).
+template <typename T>
+class VectorSink : public Sink<T> {
+  std::vector<T> data_;
+
+ public:
+  void push(T const& value) override { data_.push_back(value); }
+
+  void reserve(std::size_t n) { data_.reserve(n); }
+  std::vector<T> const& data() const { return data_; }
+};
+
+// Keeps only the last capacity() values, memory use is constant.
+template <typename T>
+class RingSink : public Sink<T> {
+  std::vector<T> buffer_;
+  std::size_t capacity_;
+  std::size_t next_{0};   // slot written by the next push()
+  std::size_t total_{0};  // values pushed so far
+
+ public:
+  explicit RingSink(std::size_t capacity) : capacity_(capacity) {
+    if (capacity == 0) throw std::invalid_argument("Invalid input.");
+    buffer_.reserve(capacity);
+  }
+
+  void push(T const& value) override {
+    if (buffer_.size() < capacity_) {
+      buffer_.push_back(value);
+    } else {
+      buffer_[next_] = value;
+    }
+    next_ = (next_ + 1) % capacity_;
+    ++total_;
+  }
+
+  std::size_t capacity() const { return capacity_; }
+  std::size_t size() const { return buffer_.size(); }
+  std::size_t total() const { return total_; }
+
+  // i = 0 is the oldest value still stored
+  T const& operator[](std::size_t i) const {
+    return buffer_.size() < capacity_ ? buffer_[i]
+                                      : buffer_[(next_ + i) % capacity_];
+  }
+
+  // drops every stored value, the capacity stays
+  void clear() {
+    buffer_.clear();
+    next_ = 0;
+    total_ = 0;
+  }
+
+  std::vector<T> data() const {
+    std::vector<T> ordered;
+    ordered.reserve(size());
+    for (std::size_t i{0}; i < size(); ++i) ordered.push_back((*this)[i]);
+    return ordered;
+  }
+};
+
+// Hands every value to a user function.
+template <typename T>
+class CallbackSink : public Sink<T> {
+  std::function<void(T const&)> callback_;
+
+ public:
+  explicit CallbackSink(std::function<void(T const&)> callback)
+      : callback_(std::move(callback)) {
+    if (!callback_) throw std::invalid_argument("Invalid input.");
+  }
+
+  void push(T const& value) override { callback_(value); }
+};
+
+// Writes every value to a tab-separated file as soon as it is produced.
+// Rows are formatted by the write_row() overload found for T, or for
+// Timed<T> after stamp_time(), which also adds a "t" column to the header.
+// The header is written with the first row.
+template <typename T>
+class FileSink : public Sink<T> {
+  static constexpr bool stampable =
+      requires(std::ostream& out, T const& value) {
+        write_row(out, std::size_t{}, Timed<T>{value});
+      };
+
+  std::ofstream file_;
+  std::string header_;
+  std::size_t rows_{0};
+  bool timed_{false};
+  bool started_{false};
+
+  void start() {
+    if (started_) return;
+    if (timed_) file_ << "t\t";
+    file_ << header_ << '\n';
+    started_ = true;
+  }
+
+ public:
+  FileSink(std::string const& filename, std::string header)
+      : file_(filename), header_(std::move(header)) {
+    if (!file_) throw std::runtime_error("Cannot open " + filename + ".");
+  }
+  FileSink(FileSink const&) = delete;
+  FileSink& operator=(FileSink const&) = delete;
+  ~FileSink() override { start(); }
+
+  void push(T const& value) override {
+    start();
+    if constexpr (stampable) {
+      if (timed_) {
+        write_row(file_, rows_++, Timed<T>{value});
+        return;
+      }
+    }
+    write_row(file_, rows_++, value);
+  }
+  void flush() override {
+    start();
+    file_.flush();
+  }
+  void stamp_time() override {
+    if (started_) throw std::logic_error("The header is already written.");
+    if constexpr (stampable) timed_ = true;
+  }
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// the VectorSink at the end of a chain of forwarding sinks, or nullptr
+template <typename T>
+VectorSink<T> const* memory_of(Sink<T> const& sink) {
+  Sink<T> const* current = &sink;
+  while (current->forwards_to() != nullptr) current = current->forwards_to();
+  return dynamic_cast<VectorSink<T> const*>(current);
+}
+
+}  // namespace volterra
+
+#endif
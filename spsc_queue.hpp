@@ -0,0 +1,81 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread. push() and pop() block (without spinning) while the
+// queue is full or empty, which gives back-pressure to the producer.
+template <typename T>
+class SpscQueue {
+  std::vector<T> slots_;
+  // monotonic counters, the slot is counter % capacity; on separate cache
+  // lines so that the two threads do not invalidate each other
+  alignas(64) std::atomic<std::size_t> head_{0};  // next pop
+  alignas(64) std::atomic<std::size_t> tail_{0};  // next push
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  explicit SpscQueue(std::size_t capacity) : slots_(capacity) {
+    if (capacity == 0) throw std::invalid_argument("Invalid input.");
+  }
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  std::size_t capacity() const { return slots_.size(); }
+
+  // producer side
+  bool try_push(T& value) {
+    std::size_t const tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail % slots_.size()] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    tail_.notify_one();
+    return true;
+  }
+
+  void push(T value) {
+    while (!try_push(value)) {
+      // full: sleep until the consumer moves head_
+      std::size_t const head = head_.load(std::memory_order_acquire);
+      if (tail_.load(std::memory_order_relaxed) - head == slots_.size()) {
+        head_.wait(head, std::memory_order_acquire);
+      }
+    }
+  }
+
+  // consumer side
+  bool try_pop(T& value) {
+    std::size_t const head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return false;
+    value = std::move(slots_[head % slots_.size()]);
+    head_.store(head + 1, std::memory_order_release);
+    head_.notify_one();
+    return true;
+  }
+
+  T pop() {
+    T value;
+    while (!try_pop(value)) {
+      // empty: sleep until the producer moves tail_
+      std::size_t const tail = tail_.load(std::memory_order_acquire);
+      if (head_.load(std::memory_order_relaxed) == tail) {
+        tail_.wait(tail, std::memory_order_acquire);
+      }
+    }
+    return value;
+  }
+};
+
+}  // namespace volterra
+
+#endif
@@ -0,0 +1,333 @@
+#include "stability_map.hpp"
+
+#include "lane_step.hpp"
+#include "svg_plot.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace volterra {
+
+namespace {
+
+constexpr std::array<char, 8> magic{'V', 'O', 'L', 'S', 'W', 'E', 'E', 'P'};
+constexpr std::uint32_t version{2};
+
+// runs advanced together: square tiles of the slice, tile_side cells a
+// side, so that the working set of a tile (12 doubles per run) stays in the
+// L1 cache and its runs, with close parameters, tend to die out together
+constexpr std::size_t tile_side{16};
+
+// the state and the running metrics of a tile, one entry per run
+struct Tile {
+  std::vector<double> x;  // prey, relative coordinate x*c/d
+  std::vector<double> y;  // predator, relative coordinate y*b/a
+  std::vector<double> a;
+  std::vector<double> d;
+  std::vector<double> dt;
+  std::vector<double> H_0;  // Hamiltonian less a constant, see step_tile()
+  std::vector<double> drift;
+  std::vector<double> alive;
+  std::vector<double> steps;
+  std::vector<double> first;  // first and last crossing, in steps
+  std::vector<double> last;
+  std::vector<double> crossings;
+
+  explicit Tile(std::size_t n)
+      : x(n), y(n), a(n), d(n), dt(n), H_0(n), drift(n), alive(n, 1.),
+        steps(n), first(n), last(n), crossings(n) {}
+};
+
+// One step of Simulation::evolve() on n runs, by the step_lane() shared with
+// Ensemble, followed by the update of the crossings. Plain arithmetic, so
+// that the pragma (-fopenmp-simd) vectorizes it.
+// The section x = d/c is x = 1: an upward crossing is interpolated between
+// the two steps. Runs that would go extinct stay frozen and stop counting.
+void step_tile(double* __restrict__ x, double* __restrict__ y,
+               double const* __restrict__ a, double const* __restrict__ d,
+               double const* __restrict__ dt, double* __restrict__ alive,
+               double* __restrict__ steps, double* __restrict__ first,
+               double* __restrict__ last, double* __restrict__ crossings,
+               std::size_t n) {
+#pragma omp simd
+  for (std::size_t i = 0; i < n; ++i) {
+    double const x_rel = x[i];
+    double x_next = x_rel;
+    double y_next = y[i];
+    bool const ok =
+        step_lane(x_next, y_next, a[i], d[i], dt[i], alive[i] != 0.0);
+    double const mask = ok ? 1.0 : 0.0;
+
+    // t is not finite when there is no crossing, and then it is not used;
+    // first and last are loaded unconditionally so that the stores blend
+    double const cross = (x_rel < 1) & (x_next >= 1) ? mask : 0.0;
+    double const first_cross = crossings[i] == 0.0 ? cross : 0.0;
+    double const t = steps[i] + (1 - x_rel) / (x_next - x_rel);
+    double const first_i = first[i];
+    double const last_i = last[i];
+    first[i] = first_cross != 0.0 ? t : first_i;
+    last[i] = cross != 0.0 ? t : last_i;
+    crossings[i] += cross;
+
+    x[i] = x_next;
+    y[i] = y_next;
+    alive[i] = mask;
+    steps[i] += mask;
+  }
+}
+
+// Drift of the runs still alive after step_tile(), the only place with
+// logarithms. In relative coordinates H is d (x - log x) + a (y - log y)
+// plus a constant, which the drift ignores.
+void measure_tile(double const* x, double const* y, double const* a,
+                  double const* d, double const* H_0, double* drift,
+                  double const* alive, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (alive[i] == 0.0) continue;
+    double const H =
+        d[i] * (x[i] - std::log(x[i])) + a[i] * (y[i] - std::log(y[i]));
+    drift[i] = std::max(drift[i], std::abs(H - H_0[i]));
+  }
+}
+
+void set(SweepAxis axis, double value, Parameters& p, double& dt) {
+  switch (axis) {
+    case SweepAxis::A:
+      p.a = value;
+      break;
+    case SweepAxis::B:
+      p.b = value;
+      break;
+    case SweepAxis::C:
+      p.c = value;
+      break;
+    case SweepAxis::D:
+      p.d = value;
+      break;
+    case SweepAxis::Dt:
+      dt = value;
+      break;
+  }
+}
+
+bool valid(AxisRange const& range) {
+  return range.count != 0 && range.min > 0 && range.max > range.min &&
+         std::isfinite(range.max) && range.axis >= SweepAxis::A &&
+         range.axis <= SweepAxis::Dt;
+}
+
+// VALIDATE()
+void validate(StabilitySweep const& s) {
+  if (!valid(s.columns) || !valid(s.rows) || s.columns.axis == s.rows.axis ||
+      s.steps == 0 || s.drift_stride == 0) {
+    throw std::invalid_argument("Invalid input.");
+  }
+  // the values that are not swept
+  Parameters p = s.p;
+  double dt = s.dt;
+  set(s.columns.axis, 1., p, dt);
+  set(s.rows.axis, 1., p, dt);
+  for (double v : {p.a, p.b, p.c, p.d, dt, s.x, s.y}) {
+    if (!(v > 0) || !std::isfinite(v)) {
+      throw std::invalid_argument("Invalid input.");
+    }
+  }
+}
+
+// RUN_TILE()
+// The rows [row, row + rows) by the columns [column, column + columns) of
+// the map; run i of the tile is cell (i / columns, i % columns) of it.
+void run_tile(StabilityMap& map, std::size_t row, std::size_t rows,
+              std::size_t column, std::size_t columns) {
+  StabilitySweep const& s = map.sweep;
+  std::size_t const n = rows * columns;
+  auto const cell = [&](std::size_t i) {
+    return (row + i / columns) * s.columns.count + column + i % columns;
+  };
+
+  Tile tile{n};
+  for (std::size_t i{0}; i < n; ++i) {
+    Parameters p = s.p;
+    double dt = s.dt;
+    set(s.columns.axis, s.columns.value(column + i % columns), p, dt);
+    set(s.rows.axis, s.rows.value(row + i / columns), p, dt);
+
+    // Coordinate change, same as Simulation's constructor
+    tile.x[i] = s.x * p.c / p.d;
+    tile.y[i] = s.y * p.b / p.a;
+    tile.a[i] = p.a;
+    tile.d[i] = p.d;
+    tile.dt[i] = dt;
+    tile.H_0[i] = p.d * (tile.x[i] - std::log(tile.x[i])) +
+                  p.a * (tile.y[i] - std::log(tile.y[i]));
+  }
+
+  for (std::size_t step{1}; step <= s.steps; ++step) {
+    step_tile(tile.x.data(), tile.y.data(), tile.a.data(), tile.d.data(),
+              tile.dt.data(), tile.alive.data(), tile.steps.data(),
+              tile.first.data(), tile.last.data(), tile.crossings.data(), n);
+    if (step % s.drift_stride == 0 || step == s.steps) {
+      measure_tile(tile.x.data(), tile.y.data(), tile.a.data(),
+                   tile.d.data(), tile.H_0.data(), tile.drift.data(),
+                   tile.alive.data(), n);
+    }
+  }
+
+  for (std::size_t i{0}; i < n; ++i) {
+    map.drift[cell(i)] = tile.drift[i];
+    map.period[cell(i)] =
+        tile.crossings[i] < 2
+            ? std::numeric_limits<double>::quiet_NaN()
+            : (tile.last[i] - tile.first[i]) / (tile.crossings[i] - 1) *
+                  tile.dt[i];
+    map.steps[cell(i)] = tile.steps[i];
+  }
+}
+
+char const* name_of(SweepAxis axis) {
+  switch (axis) {
+    case SweepAxis::A:
+      return "a";
+    case SweepAxis::B:
+      return "b";
+    case SweepAxis::C:
+      return "c";
+    case SweepAxis::D:
+      return "d";
+    case SweepAxis::Dt:
+      break;
+  }
+  return "dt";
+}
+
+}  // namespace
+
+// VALUES()
+std::vector<double> const& StabilityMap::values(
+    StabilityMetric metric) const {
+  switch (metric) {
+    case StabilityMetric::Drift:
+      return drift;
+    case StabilityMetric::Period:
+      return period;
+    case StabilityMetric::Steps:
+      break;
+  }
+  return steps;
+}
+
+// STABILITY_MAP()
+StabilityMap stability_map(StabilitySweep const& sweep, ThreadPool& pool) {
+  validate(sweep);
+  std::size_t const cells = sweep.columns.count * sweep.rows.count;
+  StabilityMap map{sweep, std::vector<double>(cells),
+                   std::vector<double>(cells), std::vector<double>(cells)};
+
+  std::size_t const columns = (sweep.columns.count + tile_side - 1) / tile_side;
+  std::size_t const rows = (sweep.rows.count + tile_side - 1) / tile_side;
+  parallel_for(pool, rows * columns, [&](std::size_t tile) {
+    std::size_t const row = tile / columns * tile_side;
+    std::size_t const column = tile % columns * tile_side;
+    run_tile(map, row, std::min(tile_side, sweep.rows.count - row), column,
+             std::min(tile_side, sweep.columns.count - column));
+  });
+  return map;
+}
+
+// WRITE_STABILITY_MAP()
+void write_stability_map(std::string const& filename,
+                         StabilityMap const& map) {
+  StabilitySweep const& s = map.sweep;
+  StabilityHeader header{};
+  header.magic = magic;
+  header.version = version;
+  header.byte_order = 1;
+  header.column_axis = s.columns.axis;
+  header.row_axis = s.rows.axis;
+  header.columns = s.columns.count;
+  header.rows = s.rows.count;
+  header.steps = s.steps;
+  header.drift_stride = s.drift_stride;
+  header.values = {s.p.a, s.p.b, s.p.c, s.p.d, s.x, s.y, s.dt,
+                   s.columns.min, s.columns.max, s.rows.min, s.rows.max};
+
+  std::ofstream out{filename, std::ios::binary};
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+  out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  for (auto const* column : {&map.drift, &map.period, &map.steps}) {
+    out.write(reinterpret_cast<char const*>(column->data()),
+              static_cast<std::streamsize>(column->size() * sizeof(double)));
+  }
+  out.close();
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+}
+
+// READ_STABILITY_MAP()
+StabilityMap read_stability_map(std::string const& filename) {
+  std::ifstream in{filename, std::ios::binary};
+  if (!in) throw std::runtime_error("Cannot open " + filename + ".");
+  in.seekg(0, std::ios::end);
+  auto const size = static_cast<std::size_t>(in.tellg());
+  in.seekg(0);
+
+  StabilityHeader header{};
+  if (size >= sizeof(header)) {
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  }
+  std::size_t const cells = header.columns * header.rows;
+  bool const valid_file =
+      size >= sizeof(header) && header.magic == magic &&
+      header.version == version && header.byte_order == 1 &&
+      header.column_axis <= SweepAxis::Dt && header.row_axis <= SweepAxis::Dt &&
+      header.drift_stride != 0 && header.rows != 0 &&
+      cells / header.rows == header.columns &&
+      cells <= (size - sizeof(header)) / 24 &&
+      size == sizeof(header) + 24 * cells;
+  if (!valid_file) {
+    throw std::runtime_error(filename + " is not a stability map.");
+  }
+
+  auto const& v = header.values;
+  StabilitySweep sweep{{v[0], v[1], v[2], v[3]}, v[4], v[5], v[6],
+                       static_cast<std::size_t>(header.steps),
+                       {header.column_axis, v[7], v[8], 0},
+                       {header.row_axis, v[9], v[10], 0}};
+  sweep.columns.count = static_cast<std::size_t>(header.columns);
+  sweep.rows.count = static_cast<std::size_t>(header.rows);
+  sweep.drift_stride = static_cast<std::size_t>(header.drift_stride);
+  StabilityMap map{sweep, std::vector<double>(cells),
+                   std::vector<double>(cells), std::vector<double>(cells)};
+  for (auto* column : {&map.drift, &map.period, &map.steps}) {
+    in.read(reinterpret_cast<char*>(column->data()),
+            static_cast<std::streamsize>(cells * sizeof(double)));
+  }
+  if (!in) throw std::runtime_error("Cannot read " + filename + ".");
+  return map;
+}
+
+// SAVE_STABILITY_HEATMAP()
+void save_stability_heatmap(std::string const& filename,
+                            StabilityMap const& map,
+                            StabilityMetric metric) {
+  StabilitySweep const& s = map.sweep;
+  char const* const title = metric == StabilityMetric::Drift
+                                ? "HAMILTONIAN DRIFT"
+                            : metric == StabilityMetric::Period
+                                ? "PERIOD"
+                                : "STEPS BEFORE EXTINCTION";
+  PlotStyle const style{title, name_of(s.columns.axis), name_of(s.rows.axis)};
+  Heatmap const heatmap{s.columns.count,
+                        s.rows.count,
+                        s.columns.min,
+                        s.columns.max,
+                        s.rows.min,
+                        s.rows.max,
+                        map.values(metric),
+                        metric == StabilityMetric::Drift};
+  save_heatmap(filename, style, heatmap);
+}
+
+}  // namespace volterra
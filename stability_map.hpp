@@ -0,0 +1,105 @@
+#ifndef STABILITY_MAP_HPP
+#define STABILITY_MAP_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "simulation.hpp"
+#include "thread_pool.hpp"
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+enum class SweepAxis : std::uint32_t { A = 0, B, C, D, Dt };
+
+// count cells covering [min, max]; the run of cell i uses the value at its
+// center, min + (i + 0.5) * (max - min) / count
+struct AxisRange {
+  SweepAxis axis;
+  double min;
+  double max;
+  std::size_t count;
+
+  double value(std::size_t i) const {
+    return min + (static_cast<double>(i) + 0.5) * (max - min) /
+                     static_cast<double>(count);
+  }
+};
+
+// A 2-D slice of (a, b, c, d, dt): every run starts from (x, y) and takes
+// steps integration steps, with the values of p and dt that are not swept.
+// A Simulation taking as many steps has iterations() = steps + 1, the
+// initial state included.
+struct StabilitySweep {
+  Parameters p;
+  double x;
+  double y;
+  double dt;
+  std::size_t steps;
+  AxisRange columns;  // horizontal axis
+  AxisRange rows;     // vertical axis
+  // H, the only costly part of a step, is evaluated every drift_stride
+  // steps and on the last one (1 = every step)
+  std::size_t drift_stride{1};
+};
+
+enum class StabilityMetric { Drift, Period, Steps };
+
+// Metrics of every run, row-major (rows.count by columns.count):
+//   drift:  largest |H - H_0| before extinction, on the steps where H is
+//           evaluated (see drift_stride)
+//   period: mean period on the section x = d/c (as OrbitAnalyzer), NaN
+//           without two crossings
+//   steps:  steps taken before extinction, sweep.steps if the run survived
+struct StabilityMap {
+  StabilitySweep sweep;
+  std::vector<double> drift;
+  std::vector<double> period;
+  std::vector<double> steps;
+
+  std::vector<double> const& values(StabilityMetric metric) const;
+};
+
+// Binary map: this 144-byte header, then the drift, period and steps
+// columns (double, rows * columns values each) in native byte order.
+struct StabilityHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t byte_order;  // 1 when read with the writer's byte order
+  SweepAxis column_axis;
+  SweepAxis row_axis;
+  std::uint64_t columns;
+  std::uint64_t rows;
+  std::uint64_t steps;
+  // a, b, c, d, x, y, dt, then min and max of the columns and of the rows
+  std::array<double, 11> values;
+  std::uint64_t drift_stride;
+};
+static_assert(sizeof(StabilityHeader) == 144);
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// Runs the whole slice on the pool. The runs are batched in square tiles of
+// the slice, advanced together by a branch-free, vectorized version of
+// Simulation::evolve() that also updates the crossings at every step, so no
+// trajectory is stored. Throws std::invalid_argument for an empty or
+// non-positive range, a zero drift_stride, or invalid fixed values.
+StabilityMap stability_map(StabilitySweep const& sweep, ThreadPool& pool);
+
+// throw std::runtime_error if the file cannot be written or read, or is not
+// a stability map (unknown axes included)
+void write_stability_map(std::string const& filename,
+                         StabilityMap const& map);
+StabilityMap read_stability_map(std::string const& filename);
+
+// one metric as a heatmap (drift on a logarithmic scale)
+void save_stability_heatmap(std::string const& filename,
+                            StabilityMap const& map, StabilityMetric metric);
+
+}  // namespace volterra
+
+#endif
@@ -0,0 +1,179 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "stability_map.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+#include "doctest.h"
+#include "ensemble.hpp"
+#include "orbit_analyzer.hpp"
+
+namespace {
+
+// a by dt slice, some runs of which go extinct
+volterra::StabilitySweep const sweep{{2., 1., 1., 3.},
+                                     5.,
+                                     1.,
+                                     0.,
+                                     3000,
+                                     {volterra::SweepAxis::Dt, 0.001, 0.3, 20},
+                                     {volterra::SweepAxis::A, 0.5, 4., 15}};
+
+volterra::Parameters parameters_of(std::size_t row) {
+  return {sweep.rows.value(row), 1., 1., 3.};
+}
+
+}  // namespace
+
+TEST_CASE("Testing stability_map() against Simulation and OrbitAnalyzer") {
+  volterra::ThreadPool pool{3};
+  auto const map = volterra::stability_map(sweep, pool);
+  REQUIRE(map.drift.size() == std::size_t(300));
+  REQUIRE(map.period.size() == std::size_t(300));
+  REQUIRE(map.steps.size() == std::size_t(300));
+
+  std::size_t survived{0};
+  for (std::size_t row{0}; row < sweep.rows.count; ++row) {
+    for (std::size_t column{0}; column < sweep.columns.count; ++column) {
+      std::size_t const cell = row * sweep.columns.count + column;
+      auto const p = parameters_of(row);
+      double const dt = sweep.columns.value(column);
+
+      // extinction, as Ensemble
+      volterra::Ensemble ensemble;
+      ensemble.add(p, sweep.x, sweep.y, dt);
+      ensemble.evolve_n(sweep.steps);
+      CHECK(map.steps[cell] == static_cast<double>(ensemble.steps(0)));
+      if (!ensemble.alive(0)) continue;
+      ++survived;
+
+      // drift and period, as OrbitAnalyzer on every step
+      volterra::Simulation sim(p, sweep.x, sweep.y, dt,
+                               static_cast<double>(sweep.steps + 1));
+      auto analyzer = std::make_shared<volterra::OrbitAnalyzer>(p);
+      sim.set_sink(std::make_shared<volterra::RingSink<volterra::State>>(1));
+      sim.set_analyzer(analyzer);
+      sim.go();
+
+      double const drift =
+          std::max(analyzer->drift_max(), -analyzer->drift_min());
+      CHECK(map.drift[cell] == doctest::Approx(drift).epsilon(1e-6));
+      if (analyzer->periods() == 0) {
+        CHECK(std::isnan(map.period[cell]));
+      } else {
+        CHECK(map.period[cell] ==
+              doctest::Approx(analyzer->period()).epsilon(1e-9));
+      }
+    }
+  }
+  // both outcomes are covered
+  CHECK(survived > std::size_t(0));
+  CHECK(survived < std::size_t(300));
+}
+
+TEST_CASE("Testing stability_map() with a drift stride") {
+  volterra::ThreadPool pool{2};
+  auto const every = volterra::stability_map(sweep, pool);
+  auto sampled_sweep = sweep;
+  sampled_sweep.drift_stride = 7;
+  auto const sampled = volterra::stability_map(sampled_sweep, pool);
+
+  // only the drift is sampled, and it can only miss the largest values
+  CHECK(sampled.steps == every.steps);
+  bool some_lower{false};
+  for (std::size_t i{0}; i < every.drift.size(); ++i) {
+    CHECK(sampled.drift[i] <= every.drift[i]);
+    CHECK((sampled.period[i] == every.period[i] ||
+           (std::isnan(sampled.period[i]) && std::isnan(every.period[i]))));
+    some_lower = some_lower || sampled.drift[i] < every.drift[i];
+  }
+  CHECK(some_lower);
+}
+
+TEST_CASE("Testing stability_map() input") {
+  volterra::ThreadPool pool{1};
+  auto bad = sweep;
+  bad.rows.axis = volterra::SweepAxis::Dt;
+  CHECK_THROWS(volterra::stability_map(bad, pool));
+  bad = sweep;
+  bad.rows.count = 0;
+  CHECK_THROWS(volterra::stability_map(bad, pool));
+  bad = sweep;
+  bad.columns.min = 0.;
+  CHECK_THROWS(volterra::stability_map(bad, pool));
+  bad = sweep;
+  bad.p.d = -3.;
+  CHECK_THROWS(volterra::stability_map(bad, pool));
+  bad = sweep;
+  bad.steps = 0;
+  CHECK_THROWS(volterra::stability_map(bad, pool));
+  bad = sweep;
+  bad.drift_stride = 0;
+  CHECK_THROWS(volterra::stability_map(bad, pool));
+  // the fixed value of a swept parameter is not used
+  bad = sweep;
+  bad.p.a = -1.;
+  CHECK_NOTHROW(volterra::stability_map(bad, pool));
+}
+
+TEST_CASE("Testing write_stability_map() and read_stability_map()") {
+  volterra::ThreadPool pool{2};
+  auto const map = volterra::stability_map(sweep, pool);
+  std::string const filename{"stability_map_test.bin"};
+  volterra::write_stability_map(filename, map);
+
+  auto const read = volterra::read_stability_map(filename);
+  CHECK(read.sweep.p == sweep.p);
+  CHECK(read.sweep.x == sweep.x);
+  CHECK(read.sweep.steps == sweep.steps);
+  CHECK(read.sweep.drift_stride == sweep.drift_stride);
+  CHECK(read.sweep.columns.axis == volterra::SweepAxis::Dt);
+  CHECK(read.sweep.rows.max == sweep.rows.max);
+  CHECK(read.sweep.rows.count == sweep.rows.count);
+  CHECK(read.drift == map.drift);
+  CHECK(read.steps == map.steps);
+  for (std::size_t i{0}; i < map.period.size(); ++i) {
+    CHECK((read.period[i] == map.period[i] ||
+           (std::isnan(read.period[i]) && std::isnan(map.period[i]))));
+  }
+
+  // unknown axis
+  {
+    std::fstream file{filename,
+                      std::ios::binary | std::ios::in | std::ios::out};
+    file.seekp(offsetof(volterra::StabilityHeader, row_axis));
+    std::uint32_t const axis{5};
+    file.write(reinterpret_cast<char const*>(&axis), sizeof(axis));
+  }
+  CHECK_THROWS_AS(volterra::read_stability_map(filename), std::runtime_error);
+
+  // truncated file
+  {
+    std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+    out << "VOLSWEEP";
+  }
+  CHECK_THROWS_AS(volterra::read_stability_map(filename), std::runtime_error);
+  std::remove(filename.c_str());
+  CHECK_THROWS_AS(volterra::read_stability_map(filename), std::runtime_error);
+}
+
+TEST_CASE("Testing save_stability_heatmap()") {
+  volterra::ThreadPool pool{2};
+  auto const map = volterra::stability_map(sweep, pool);
+  std::string const filename{"stability_map_test.svg"};
+  for (auto metric :
+       {volterra::StabilityMetric::Drift, volterra::StabilityMetric::Period,
+        volterra::StabilityMetric::Steps}) {
+    volterra::save_stability_heatmap(filename, map, metric);
+    std::ifstream in{filename};
+    std::string first_line;
+    std::getline(in, first_line);
+    CHECK(first_line.rfind("<?xml", 0) == 0);
+  }
+  std::remove(filename.c_str());
+}
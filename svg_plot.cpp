@@ -0,0 +1,485 @@
+#include "svg_plot.hpp"
+
+#include "downsample.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace volterra {
+
+namespace {
+
+// margins of the plot area, in pixels
+constexpr double left{90.};
+constexpr double right{30.};
+constexpr double top{50.};
+constexpr double bottom{70.};
+
+// pixel coordinates are clamped to this distance from the origin: points
+// far outside fixed axis limits are clipped anyway, and their text stays
+// within the formatting buffers
+constexpr double max_pixel{1e9};
+
+struct Range {
+  double min;
+  double max;
+};
+
+// fixed-point text of value with the given decimals
+std::string fixed(double value, int decimals) {
+  char buffer[64];
+  auto const result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                    std::chars_format::fixed, decimals);
+  std::string text{buffer, result.ptr};
+  return text == "-0" ? "0" : text;
+}
+
+double clamp_pixel(double v) { return std::clamp(v, -max_pixel, max_pixel); }
+
+// NICE_STEP()
+// 1, 2 or 5 times a power of ten, giving about 5 to 10 ticks over span.
+double nice_step(double span) {
+  double const raw = span / 8.;
+  double const power = std::pow(10., std::floor(std::log10(raw)));
+  double const fraction = raw / power;
+  double const nice = fraction < 1.5 ? 1. : fraction < 3.5 ? 2.
+                      : fraction < 7.5 ? 5. : 10.;
+  return nice * power;
+}
+
+// the multiples of step within range
+std::vector<double> ticks(Range const& range, double step) {
+  std::vector<double> values;
+  auto const first = static_cast<long long>(std::ceil(range.min / step - 1e-9));
+  auto const last = static_cast<long long>(std::floor(range.max / step + 1e-9));
+  for (long long k{first}; k <= last; ++k) {
+    values.push_back(static_cast<double>(k) * step);
+  }
+  return values;
+}
+
+int decimals_of(double step) {
+  return std::max(0, -static_cast<int>(std::floor(std::log10(step) + 1e-9)));
+}
+
+// XML special characters in labels and titles
+std::string escape(std::string const& text) {
+  std::string escaped;
+  for (char c : text) {
+    switch (c) {
+      case '&':
+        escaped += "&amp;";
+        break;
+      case '<':
+        escaped += "&lt;";
+        break;
+      case '>':
+        escaped += "&gt;";
+        break;
+      case '"':
+        escaped += "&quot;";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// OPEN_DOCUMENT()
+// XML declaration, root element and background.
+void open_document(std::ostream& out, PlotStyle const& style) {
+  out << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"no\"?>\n"
+      << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << style.width
+      << "\" height=\"" << style.height << "\" viewBox=\"0 0 " << style.width
+      << ' ' << style.height << "\" font-family=\"" << escape(style.font)
+      << "\" font-size=\"" << style.font_size << "\">\n"
+      << "<rect width=\"100%\" height=\"100%\" fill=\"" << style.background
+      << "\"/>\n";
+}
+
+// WRITE_LABELS()
+// Title above the plot area, axis labels below and on its left.
+void write_labels(std::ostream& out, PlotStyle const& style,
+                  double plot_width, double plot_height) {
+  double const width = style.width;
+  double const height = style.height;
+  out << "<text x=\"" << width / 2 << "\" y=\"" << top / 2 + 6
+      << "\" text-anchor=\"middle\">" << escape(style.title) << "</text>\n"
+      << "<text x=\"" << left + plot_width / 2 << "\" y=\"" << height - 20
+      << "\" text-anchor=\"middle\">" << escape(style.x_label) << "</text>\n"
+      << "<text transform=\"translate(24," << top + plot_height / 2
+      << ") rotate(-90)\" text-anchor=\"middle\">" << escape(style.y_label)
+      << "</text>\n";
+}
+
+// DATA_RANGES()
+void data_ranges(std::vector<Series> const& series, double x_min,
+                 std::vector<Arrow> const& arrows, Range& x, Range& y) {
+  x = {x_min, -std::numeric_limits<double>::infinity()};
+  y = {std::numeric_limits<double>::infinity(),
+       -std::numeric_limits<double>::infinity()};
+  for (auto const& s : series) {
+    for (std::size_t i{0}; i < s.size; ++i) {
+      double const px = s.x(i);
+      double const py = s.y(i);
+      if (!std::isfinite(px) || !std::isfinite(py)) continue;
+      x.max = std::max(x.max, px);
+      y.min = std::min(y.min, py);
+      y.max = std::max(y.max, py);
+    }
+  }
+  for (auto const& arrow : arrows) {
+    x.max = std::max(x.max, arrow.x);
+    y.min = std::min(y.min, arrow.y);
+    y.max = std::max(y.max, arrow.y);
+  }
+  if (!(x.max > x.min)) x.max = x.min + 1.;
+  if (!(y.max >= y.min)) y = {0., 1.};
+  if (y.max == y.min) {
+    y.min -= 1.;
+    y.max += 1.;
+  }
+}
+
+// WRITE_POLYLINE()
+// The points (all of them, or only the kept ones) are formatted into a
+// buffer written in large pieces.
+template <typename ToX, typename ToY>
+void write_polyline(std::ostream& out, Series const& s, ToX to_x, ToY to_y,
+                    std::vector<std::size_t> const* kept) {
+  std::string points;
+  auto emit = [&](std::string const& open) {
+    if (points.empty()) return;
+    out << open << points << "\"/>\n";
+    points.clear();
+  };
+  std::string const open = "<polyline fill=\"none\" stroke=\"" + s.color +
+                           "\" stroke-width=\"2\" stroke-linejoin=\"round\""
+                           " points=\"";
+  char buffer[64];
+  std::size_t const count = kept ? kept->size() : s.size;
+  for (std::size_t n{0}; n < count; ++n) {
+    std::size_t const i = kept ? (*kept)[n] : n;
+    double const px = s.x(i);
+    double const py = s.y(i);
+    if (!std::isfinite(px) || !std::isfinite(py)) {
+      emit(open);
+      continue;
+    }
+    auto const x_text =
+        std::to_chars(buffer, buffer + sizeof(buffer) - 2,
+                      clamp_pixel(to_x(px)), std::chars_format::fixed, 2);
+    if (x_text.ec != std::errc{}) throw std::runtime_error("Invalid point.");
+    char* end = x_text.ptr;
+    *end++ = ',';
+    auto const y_text =
+        std::to_chars(end, buffer + sizeof(buffer) - 1, clamp_pixel(to_y(py)),
+                      std::chars_format::fixed, 2);
+    if (y_text.ec != std::errc{}) throw std::runtime_error("Invalid point.");
+    end = y_text.ptr;
+    *end++ = ' ';
+    points.append(buffer, end);
+    if (points.size() > (std::size_t{1} << 20)) {
+      // keep the last point so that the pieces join
+      std::string const last{buffer, end};
+      emit(open);
+      points = last;
+    }
+  }
+  emit(open);
+}
+
+// COLOR_OF()
+// Viridis-like scale: fraction 0 is dark blue, 1 is yellow.
+std::string color_of(double fraction) {
+  constexpr double stops[5][3]{{68, 1, 84},
+                               {59, 82, 139},
+                               {33, 145, 140},
+                               {94, 201, 98},
+                               {253, 231, 37}};
+  double const f = std::clamp(fraction, 0., 1.) * 4.;
+  auto const k = std::min(static_cast<int>(f), 3);
+  double const w = f - k;
+  char buffer[8];
+  buffer[0] = '#';
+  for (int c{0}; c < 3; ++c) {
+    auto const v = static_cast<unsigned>(
+        std::lround((1 - w) * stops[k][c] + w * stops[k + 1][c]));
+    char const* digits = "0123456789abcdef";
+    buffer[1 + 2 * c] = digits[v / 16];
+    buffer[2 + 2 * c] = digits[v % 16];
+  }
+  return std::string{buffer, 7};
+}
+
+}  // namespace
+
+// WRITE_SVG()
+void write_svg(std::ostream& out, PlotStyle const& style,
+               std::vector<Series> const& series,
+               std::vector<Arrow> const& arrows) {
+  Range x{};
+  Range y{};
+  data_ranges(series, style.x_min, arrows, x, y);
+  if (std::isfinite(style.x_max)) x.max = style.x_max;
+  if (std::isfinite(style.y_min)) y.min = style.y_min;
+  if (std::isfinite(style.y_max)) y.max = style.y_max;
+  if (!(x.max > x.min) || !(y.max > y.min)) {
+    throw std::invalid_argument("Invalid input.");
+  }
+
+  // free y limits are widened to whole ticks (gnuplot's autoscale), x is
+  // kept as given
+  double const x_step = nice_step(x.max - x.min);
+  double const y_step = nice_step(y.max - y.min);
+  if (!std::isfinite(style.y_min)) y.min = std::floor(y.min / y_step) * y_step;
+  if (!std::isfinite(style.y_max)) y.max = std::ceil(y.max / y_step) * y_step;
+
+  double const width = style.width;
+  double const height = style.height;
+  double const plot_width = width - left - right;
+  double const plot_height = height - top - bottom;
+  auto to_x = [&](double v) {
+    return left + (v - x.min) / (x.max - x.min) * plot_width;
+  };
+  auto to_y = [&](double v) {
+    return top + (y.max - v) / (y.max - y.min) * plot_height;
+  };
+
+  open_document(out, style);
+
+  // grid and tick labels
+  out << "<g stroke=\"#a0a0a0\" stroke-width=\"0.5\" "
+         "stroke-dasharray=\"2,4\">\n";
+  std::vector<double> const x_ticks = ticks(x, x_step);
+  std::vector<double> const y_ticks = ticks(y, y_step);
+  for (double v : x_ticks) {
+    out << "<line x1=\"" << fixed(to_x(v), 2) << "\" y1=\"" << top
+        << "\" x2=\"" << fixed(to_x(v), 2) << "\" y2=\"" << top + plot_height
+        << "\"/>\n";
+  }
+  for (double v : y_ticks) {
+    out << "<line x1=\"" << left << "\" y1=\"" << fixed(to_y(v), 2)
+        << "\" x2=\"" << left + plot_width << "\" y2=\"" << fixed(to_y(v), 2)
+        << "\"/>\n";
+  }
+  out << "</g>\n<g fill=\"black\">\n";
+  for (double v : x_ticks) {
+    out << "<text x=\"" << fixed(to_x(v), 2) << "\" y=\""
+        << top + plot_height + 20 << "\" text-anchor=\"middle\">"
+        << fixed(v, decimals_of(x_step)) << "</text>\n";
+  }
+  for (double v : y_ticks) {
+    out << "<text x=\"" << left - 8 << "\" y=\"" << fixed(to_y(v) + 5, 2)
+        << "\" text-anchor=\"end\">" << fixed(v, decimals_of(y_step))
+        << "</text>\n";
+  }
+
+  write_labels(out, style, plot_width, plot_height);
+  out << "</g>\n";
+
+  // data, clipped to the plot area
+  out << "<clipPath id=\"area\"><rect x=\"" << left << "\" y=\"" << top
+      << "\" width=\"" << plot_width << "\" height=\"" << plot_height
+      << "\"/></clipPath>\n<g clip-path=\"url(#area)\">\n";
+  if (!arrows.empty()) {
+    out << "<defs><marker id=\"head\" viewBox=\"0 0 10 10\" refX=\"10\" "
+           "refY=\"5\" markerWidth=\"6\" markerHeight=\"6\" "
+           "orient=\"auto\"><path d=\"M0,0 L10,5 L0,10 z\" "
+           "fill=\"#404040\"/></marker></defs>\n"
+        << "<g stroke=\"#404040\" stroke-width=\"1\" "
+           "marker-end=\"url(#head)\">\n";
+    for (auto const& arrow : arrows) {
+      out << "<line x1=\"" << fixed(clamp_pixel(to_x(arrow.x)), 2)
+          << "\" y1=\"" << fixed(clamp_pixel(to_y(arrow.y)), 2) << "\" x2=\""
+          << fixed(clamp_pixel(to_x(arrow.x + arrow.dx)), 2) << "\" y2=\""
+          << fixed(clamp_pixel(to_y(arrow.y + arrow.dy)), 2) << "\"/>\n";
+    }
+    out << "</g>\n";
+  }
+  auto const columns = static_cast<std::size_t>(plot_width);
+  for (auto const& s : series) {
+    if (style.downsample && s.size > 4 * columns) {
+      auto const kept = downsample(s.size, s.x, {s.y}, x.min, x.max, columns);
+      write_polyline(out, s, to_x, to_y, &kept);
+    } else {
+      write_polyline(out, s, to_x, to_y, nullptr);
+    }
+  }
+  out << "</g>\n";
+
+  // border and key (top right, as gnuplot)
+  out << "<rect x=\"" << left << "\" y=\"" << top << "\" width=\""
+      << plot_width << "\" height=\"" << plot_height
+      << "\" fill=\"none\" stroke=\"black\"/>\n";
+  double key_y = top + 20;
+  for (auto const& s : series) {
+    if (s.title.empty()) continue;
+    double const line_end = left + plot_width - 10;
+    out << "<text x=\"" << line_end - 50 << "\" y=\"" << key_y + 5
+        << "\" text-anchor=\"end\">" << escape(s.title) << "</text>\n"
+        << "<line x1=\"" << line_end - 40 << "\" y1=\"" << key_y
+        << "\" x2=\"" << line_end << "\" y2=\"" << key_y << "\" stroke=\""
+        << s.color << "\" stroke-width=\"2\"/>\n";
+    key_y += 20;
+  }
+  out << "</svg>\n";
+}
+
+// SAVE_SVG()
+void save_svg(std::string const& filename, PlotStyle const& style,
+              std::vector<Series> const& series,
+              std::vector<Arrow> const& arrows) {
+  std::ofstream out{filename};
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+  write_svg(out, style, series, arrows);
+  out.close();
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+}
+
+// WRITE_HEATMAP()
+// Cells of the same color next to each other in a row are drawn as one
+// rectangle. The color bar takes the place of the key, on the right.
+void write_heatmap(std::ostream& out, PlotStyle const& style,
+                   Heatmap const& map) {
+  if (map.columns == 0 || map.rows == 0 ||
+      map.values.size() != map.columns * map.rows ||
+      !(map.x_max > map.x_min) || !(map.y_max > map.y_min)) {
+    throw std::invalid_argument("Invalid input.");
+  }
+
+  // scale of the colors, over the finite (and, if logarithmic, positive)
+  // values
+  auto scaled = [&](double v) {
+    if (!map.logarithmic) return v;
+    return v > 0 ? std::log10(v) : std::numeric_limits<double>::quiet_NaN();
+  };
+  Range z{std::numeric_limits<double>::infinity(),
+          -std::numeric_limits<double>::infinity()};
+  for (double v : map.values) {
+    double const s = scaled(v);
+    if (!std::isfinite(s)) continue;
+    z.min = std::min(z.min, s);
+    z.max = std::max(z.max, s);
+  }
+  if (!(z.max >= z.min)) z = {0., 1.};
+  if (z.max == z.min) {
+    z.min -= 0.5;
+    z.max += 0.5;
+  }
+
+  double const bar{110.};  // room for the color bar
+  double const plot_width = style.width - left - right - bar;
+  double const plot_height = style.height - top - bottom;
+  Range const x{map.x_min, map.x_max};
+  Range const y{map.y_min, map.y_max};
+  auto to_x = [&](double v) {
+    return left + (v - x.min) / (x.max - x.min) * plot_width;
+  };
+  auto to_y = [&](double v) {
+    return top + (y.max - v) / (y.max - y.min) * plot_height;
+  };
+
+  open_document(out, style);
+
+  // cells, row 0 at the bottom
+  double const cell_width = plot_width / static_cast<double>(map.columns);
+  double const cell_height = plot_height / static_cast<double>(map.rows);
+  out << "<g shape-rendering=\"crispEdges\">\n";
+  for (std::size_t row{0}; row < map.rows; ++row) {
+    double const cell_y =
+        top + plot_height - static_cast<double>(row + 1) * cell_height;
+    std::size_t first{0};
+    std::string color;
+    for (std::size_t column{0}; column <= map.columns; ++column) {
+      std::string next;
+      if (column < map.columns) {
+        double const s = scaled(map.values[row * map.columns + column]);
+        next = std::isfinite(s) ? color_of((s - z.min) / (z.max - z.min))
+                                : "#808080";
+        if (next == color) continue;
+      }
+      if (column > 0) {
+        out << "<rect x=\""
+            << fixed(left + static_cast<double>(first) * cell_width, 2)
+            << "\" y=\"" << fixed(cell_y, 2) << "\" width=\""
+            << fixed(static_cast<double>(column - first) * cell_width, 2)
+            << "\" height=\"" << fixed(cell_height, 2) << "\" fill=\""
+            << color << "\"/>\n";
+      }
+      first = column;
+      color = next;
+    }
+  }
+  out << "</g>\n";
+
+  // tick labels, title and axis labels
+  double const x_step = nice_step(x.max - x.min);
+  double const y_step = nice_step(y.max - y.min);
+  out << "<g fill=\"black\">\n";
+  for (double v : ticks(x, x_step)) {
+    out << "<text x=\"" << fixed(to_x(v), 2) << "\" y=\""
+        << top + plot_height + 20 << "\" text-anchor=\"middle\">"
+        << fixed(v, decimals_of(x_step)) << "</text>\n";
+  }
+  for (double v : ticks(y, y_step)) {
+    out << "<text x=\"" << left - 8 << "\" y=\"" << fixed(to_y(v) + 5, 2)
+        << "\" text-anchor=\"end\">" << fixed(v, decimals_of(y_step))
+        << "</text>\n";
+  }
+  write_labels(out, style, plot_width, plot_height);
+
+  // color bar, with the values of the scale (powers of ten if logarithmic)
+  double const bar_x = left + plot_width + 30;
+  double const z_step = nice_step(z.max - z.min);
+  for (double v : ticks(z, z_step)) {
+    double const bar_y =
+        top + (z.max - v) / (z.max - z.min) * plot_height + 5;
+    std::string label;
+    if (map.logarithmic) {
+      char buffer[32];
+      label.assign(buffer,
+                   std::to_chars(buffer, buffer + sizeof(buffer),
+                                 std::pow(10., v),
+                                 std::chars_format::general, 3)
+                       .ptr);
+    } else {
+      label = fixed(v, decimals_of(z_step));
+    }
+    out << "<text x=\"" << bar_x + 28 << "\" y=\"" << fixed(bar_y, 2)
+        << "\">" << label << "</text>\n";
+  }
+  out << "</g>\n<defs><linearGradient id=\"scale\" x1=\"0\" y1=\"1\" "
+         "x2=\"0\" y2=\"0\">\n";
+  for (int k{0}; k <= 8; ++k) {
+    out << "<stop offset=\"" << fixed(k / 8., 3) << "\" stop-color=\""
+        << color_of(k / 8.) << "\"/>\n";
+  }
+  out << "</linearGradient></defs>\n"
+      << "<rect x=\"" << bar_x << "\" y=\"" << top
+      << "\" width=\"20\" height=\"" << plot_height
+      << "\" fill=\"url(#scale)\" stroke=\"black\"/>\n";
+
+  // border
+  out << "<rect x=\"" << left << "\" y=\"" << top << "\" width=\""
+      << plot_width << "\" height=\"" << plot_height
+      << "\" fill=\"none\" stroke=\"black\"/>\n</svg>\n";
+}
+
+// SAVE_HEATMAP()
+void save_heatmap(std::string const& filename, PlotStyle const& style,
+                  Heatmap const& map) {
+  std::ofstream out{filename};
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+  write_heatmap(out, style, map);
+  out.close();
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+}
+
+}  // namespace volterra
@@ -0,0 +1,95 @@
+#ifndef SVG_PLOT_HPP
+#define SVG_PLOT_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+// One line of a plot, read point by point from the caller's data, so that
+// nothing is copied before it is written.
+struct Series {
+  std::string title;
+  std::string color;  // any SVG color
+  std::size_t size;
+  std::function<double(std::size_t)> x;
+  std::function<double(std::size_t)> y;
+};
+
+// An arrow from (x, y) to (x + dx, y + dy), in data coordinates.
+struct Arrow {
+  double x;
+  double y;
+  double dx;
+  double dy;
+};
+
+// Same look as the former gnuplot script: svg terminal 1000x600,
+// Arial 14, light blue background, grid, lines of width 2. The x range
+// goes from x_min to the largest x, the y range is widened to whole ticks;
+// the limits that are given (not NaN) are used as they are.
+// With downsample, a series with many more points than pixel columns is
+// reduced to the few per column that decide its look (see downsample()),
+// so the file stays small whatever the length of the run.
+struct PlotStyle {
+  std::string title;
+  std::string x_label;
+  std::string y_label;
+  double x_min{0.};
+  double x_max{std::numeric_limits<double>::quiet_NaN()};
+  double y_min{std::numeric_limits<double>::quiet_NaN()};
+  double y_max{std::numeric_limits<double>::quiet_NaN()};
+  int width{1000};
+  int height{600};
+  std::string font{"Arial"};
+  int font_size{14};
+  std::string background{"#99d6e1"};
+  bool downsample{true};  // only for x not decreasing along each series
+};
+
+// Values of a grid of rows by columns cells, row-major, covering the
+// rectangle [x_min, x_max] x [y_min, y_max] with row 0 at the bottom.
+// Cells whose value is not finite (or not positive on a logarithmic scale)
+// are drawn gray.
+struct Heatmap {
+  std::size_t columns;
+  std::size_t rows;
+  double x_min;
+  double x_max;
+  double y_min;
+  double y_max;
+  std::vector<double> values;
+  bool logarithmic{false};
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// Writes a line plot as a standalone SVG document, with the arrows drawn
+// under the lines. Points that are not finite break the line, series
+// without a title are left out of the key. Only the caller's data and the
+// output are touched, so plots can be written concurrently.
+void write_svg(std::ostream& out, PlotStyle const& style,
+               std::vector<Series> const& series,
+               std::vector<Arrow> const& arrows = {});
+// throws std::runtime_error if the file cannot be written
+void save_svg(std::string const& filename, PlotStyle const& style,
+              std::vector<Series> const& series,
+              std::vector<Arrow> const& arrows = {});
+
+// Writes a heatmap with a color bar as a standalone SVG document, in the
+// same style (the x_min and y limits of the style are not used).
+void write_heatmap(std::ostream& out, PlotStyle const& style,
+                   Heatmap const& map);
+// throws std::runtime_error if the file cannot be written
+void save_heatmap(std::string const& filename, PlotStyle const& style,
+                  Heatmap const& map);
+
+}  // namespace volterra
+
+#endif
@@ -0,0 +1,134 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "svg_plot.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+
+#include "doctest.h"
+#include "grid_simulation.hpp"
+#include "simulation.hpp"
+
+namespace {
+
+std::size_t count(std::string const& text, std::string const& pattern) {
+  std::size_t n{0};
+  for (auto i = text.find(pattern); i != std::string::npos;
+       i = text.find(pattern, i + 1)) {
+    ++n;
+  }
+  return n;
+}
+
+volterra::Series line(std::vector<double> const& y) {
+  return volterra::Series{
+      "A & B", "#00ff00", y.size(),
+      [](std::size_t i) { return static_cast<double>(i); },
+      [&y](std::size_t i) { return y[i]; }};
+}
+
+}  // namespace
+
+TEST_CASE("Testing write_svg()") {
+  std::vector<double> const y{3., 1., 4., 1., 5.};
+  volterra::PlotStyle const style{"TITLE <1>", "X", "Y"};
+  std::ostringstream out;
+  volterra::write_svg(out, style, {line(y)});
+  std::string const svg = out.str();
+
+  CHECK(svg.rfind("<?xml", 0) == 0);
+  CHECK(svg.find("</svg>\n") == svg.size() - 7);
+  CHECK(svg.find("width=\"1000\" height=\"600\"") != std::string::npos);
+  CHECK(svg.find("fill=\"#99d6e1\"") != std::string::npos);
+  CHECK(svg.find("TITLE &lt;1&gt;") != std::string::npos);
+  CHECK(svg.find("A &amp; B") != std::string::npos);
+  CHECK(count(svg, "<polyline") == 1);
+  // x from 0 to 4 spans the plot area, y widened to whole ticks [1, 5]
+  CHECK(svg.find("points=\"90.00,") != std::string::npos);
+  CHECK(svg.find("970.00,50.00 \"") != std::string::npos);
+}
+
+TEST_CASE("Testing write_svg() with gaps and degenerate data") {
+  std::vector<double> const gaps{1., 2., NAN, 3., 4., INFINITY, 5.};
+  std::ostringstream out;
+  volterra::write_svg(out, {}, {line(gaps)});
+  CHECK(count(out.str(), "<polyline") == 3);
+
+  std::vector<double> const flat(10, 2.);
+  std::vector<double> const empty;
+  std::ostringstream flat_out;
+  CHECK_NOTHROW(volterra::write_svg(flat_out, {}, {line(flat), line(empty)}));
+  CHECK(count(flat_out.str(), "<polyline") == 1);
+  CHECK(flat_out.str().find("nan") == std::string::npos);
+}
+
+TEST_CASE("Testing write_svg() with points far outside fixed limits") {
+  std::vector<double> const y{1., 1e300, -1e300, 2.};
+  volterra::PlotStyle style{"", "X", "Y"};
+  style.x_max = 1e-300;
+  style.y_min = 0.;
+  style.y_max = 3.;
+  std::ostringstream out;
+  volterra::write_svg(out, style, {line(y)});
+  std::string const svg = out.str();
+  CHECK(count(svg, "<polyline") == 1);
+  // the pixel coordinates are clamped, not dropped
+  CHECK(svg.find("1000000000.00,-1000000000.00 1000000000.00,1000000000.00 ") !=
+        std::string::npos);
+  CHECK(svg.find("inf") == std::string::npos);
+}
+
+TEST_CASE("Testing the simulation plots leave no other file behind") {
+  auto const directory =
+      std::filesystem::temp_directory_path() / "volterra_svg_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+
+  volterra::Simulation sim({1., 0.5, 0.2, 0.8}, 3., 2., 0.01, 2000.);
+  sim.go();
+  sim.save_plot((directory / "PLOT.svg").string());
+
+  wator::GridSimulation grid({40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1}, 11);
+  grid.go();
+  grid.save_grid_plot((directory / "GRID_PLOT.svg").string());
+
+  std::size_t files{0};
+  for (auto const& entry : std::filesystem::directory_iterator(directory)) {
+    CHECK(entry.path().extension() == ".svg");
+    CHECK(entry.file_size() > 0);
+    ++files;
+  }
+  CHECK(files == 2);
+  CHECK_THROWS_AS(sim.save_plot((directory / "missing" / "PLOT.svg").string()),
+                  std::runtime_error);
+  std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Testing write_heatmap()") {
+  // two rows of three cells, the first row of one color
+  volterra::Heatmap map{3, 2, 0., 3., 10., 12., {1., 1., 1., 2., NAN, 3.}};
+  std::ostringstream out;
+  volterra::write_heatmap(out, {"MAP", "A", "B"}, map);
+  std::string const svg = out.str();
+
+  CHECK(svg.rfind("<?xml", 0) == 0);
+  CHECK(svg.find("</svg>\n") == svg.size() - 7);
+  // 1 + 3 cell rectangles, background, color bar and border
+  CHECK(count(svg, "<rect") == 7);
+  CHECK(svg.find("fill=\"#440154\"") != std::string::npos);
+  CHECK(svg.find("fill=\"#fde725\"") != std::string::npos);
+  CHECK(svg.find("fill=\"#808080\"") != std::string::npos);
+  CHECK(svg.find("nan") == std::string::npos);
+
+  map.logarithmic = true;
+  map.values = {1e-6, 0., 1e-3, 1., 10., 100.};
+  std::ostringstream log_out;
+  volterra::write_heatmap(log_out, {}, map);
+  CHECK(log_out.str().find(">1e-06<") != std::string::npos);
+  CHECK(log_out.str().find(">100<") != std::string::npos);
+
+  map.values.pop_back();
+  CHECK_THROWS(volterra::write_heatmap(log_out, {}, map));
+}
@@ -0,0 +1,27 @@
+#ifndef TEST_FILES_HPP
+#define TEST_FILES_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// helpers shared by the tests that write files
+
+// path of a file in the temporary directory, so that the tests never write
+// in the directory they are run from
+inline std::string temporary(std::string const& name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// whole content of a file, empty if it cannot be read
+inline std::string read_file(std::filesystem::path const& path) {
+  std::ifstream in{path, std::ios::binary};
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+#endif
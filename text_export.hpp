@@ -0,0 +1,156 @@
+#ifndef TEXT_EXPORT_HPP
+#define TEXT_EXPORT_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+namespace volterra {
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// Shortest text that reads back to the same value (std::to_chars), written
+// at out; return the end of the text. A double takes at most 24 characters,
+// an integer at most 20.
+inline char* to_text(char* out, double value) {
+  return std::to_chars(out, out + 24, value).ptr;
+}
+inline char* to_text(char* out, std::size_t value) {
+  return std::to_chars(out, out + 20, value).ptr;
+}
+
+// --------------------------- CLASS ---------------------------
+
+// Buffered text file written with large bulk writes. Rows are formatted in
+// place by the format_row(char* out, std::size_t row, T const&) overload
+// found for T, which must write at most max_row characters and return the
+// end of the row.
+class TextWriter {
+  std::FILE* file_;
+  std::vector<char> buffer_;
+  std::size_t used_{0};
+  std::string filename_;
+
+ public:
+  static constexpr std::size_t max_row{256};
+
+  //-------------------------CONSTRUCTOR------------------------------
+  explicit TextWriter(std::string const& filename,
+                      std::size_t capacity = std::size_t{1} << 20)
+      : file_(std::fopen(filename.c_str(), "wb")),
+        buffer_(std::max(capacity, max_row)),
+        filename_(filename) {
+    if (file_ == nullptr) {
+      throw std::runtime_error("Cannot open " + filename + ".");
+    }
+    std::setvbuf(file_, nullptr, _IONBF, 0);  // buffer_ is the buffer
+  }
+  TextWriter(TextWriter const&) = delete;
+  TextWriter& operator=(TextWriter const&) = delete;
+  // writes what is left; call close() to see the errors
+  ~TextWriter() {
+    if (file_ == nullptr) return;
+    std::fwrite(buffer_.data(), 1, used_, file_);
+    std::fclose(file_);
+  }
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  void write(std::string_view text) {
+    if (buffer_.size() - used_ < text.size()) flush();
+    if (text.size() > buffer_.size()) {
+      bulk_write(text.data(), text.size());
+      return;
+    }
+    std::copy(text.begin(), text.end(), buffer_.data() + used_);
+    used_ += text.size();
+  }
+
+  template <typename T>
+  void row(std::size_t index, T const& value) {
+    if (buffer_.size() - used_ < max_row) flush();
+    char* const first = buffer_.data() + used_;
+    used_ += static_cast<std::size_t>(format_row(first, index, value) -
+                                      first);
+  }
+
+  void flush() {
+    bulk_write(buffer_.data(), used_);
+    used_ = 0;
+  }
+
+  void close() {
+    flush();
+    int const closed = std::fclose(file_);
+    file_ = nullptr;
+    if (closed != 0) {
+      throw std::runtime_error("Cannot write " + filename_ + ".");
+    }
+  }
+
+ private:
+  void bulk_write(char const* data, std::size_t size) {
+    if (std::fwrite(data, 1, size, file_) != size) {
+      throw std::runtime_error("Cannot write " + filename_ + ".");
+    }
+  }
+};
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// header line, then one line per row
+template <typename T>
+void write_text(std::string const& filename, std::string_view header,
+                std::span<T const> rows) {
+  TextWriter writer{filename};
+  writer.write(header);
+  writer.write("\n");
+  for (std::size_t i{0}; i < rows.size(); ++i) writer.row(i, rows[i]);
+  writer.close();
+}
+
+// Same output, with the rows formatted in parallel: blocks of rows are
+// formatted by the pool into separate buffers, a few blocks per thread at a
+// time, and written in order. The buffers are appended to and reused, so
+// they only grow to the actual text of a block.
+template <typename T>
+void write_text(std::string const& filename, std::string_view header,
+                std::span<T const> rows, ThreadPool& pool) {
+  constexpr std::size_t block{4096};
+  std::size_t const batch = 2 * pool.size();
+
+  TextWriter writer{filename};
+  writer.write(header);
+  writer.write("\n");
+
+  std::vector<std::vector<char>> buffers(batch);
+  for (std::size_t first{0}; first < rows.size(); first += batch * block) {
+    std::size_t const blocks =
+        std::min(batch, (rows.size() - first + block - 1) / block);
+    parallel_for(pool, blocks, [&](std::size_t k) {
+      std::size_t const begin = first + k * block;
+      std::size_t const end = std::min(rows.size(), begin + block);
+      auto& buffer = buffers[k];
+      buffer.clear();
+      char line[TextWriter::max_row];
+      for (std::size_t i{begin}; i < end; ++i) {
+        buffer.insert(buffer.end(), line, format_row(line, i, rows[i]));
+      }
+    });
+    for (std::size_t k{0}; k < blocks; ++k) {
+      writer.write({buffers[k].data(), buffers[k].size()});
+    }
+  }
+  writer.close();
+}
+
+}  // namespace volterra
+
+#endif
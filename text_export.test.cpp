@@ -0,0 +1,103 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "text_export.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "doctest.h"
+#include "grid_simulation.hpp"
+#include "simulation.hpp"
+#include "test_files.hpp"
+
+TEST_CASE("Testing to_text() round trips") {
+  char buffer[32];
+  for (double value : {0., 1., -2.5, 0.1, 1. / 3., 1e-300, 6.02214076e23,
+                       0.30000000000000004, 123456789.125}) {
+    char* const end = volterra::to_text(buffer, value);
+    CHECK(std::stod(std::string(buffer, end)) == value);
+  }
+  char* const end =
+      volterra::to_text(buffer, std::size_t{18446744073709551615u});
+  CHECK(std::string(buffer, end) == "18446744073709551615");
+}
+
+TEST_CASE("Testing the continuous export") {
+  volterra::Simulation sim({1., 0.5, 0.2, 0.8}, 3., 2., 0.001, 20000.);
+  sim.go();
+  std::string const filename = temporary("volterra_export.csv");
+  sim.save_evolution(filename);
+
+  // every value reads back exactly
+  std::ifstream in{filename};
+  std::string header;
+  std::getline(in, header);
+  CHECK(header == "x\ty\tH");
+  for (auto const& state : sim.evolution()) {
+    double x, y, H;
+    in >> x >> y >> H;
+    CHECK(x == state.x);
+    CHECK(y == state.y);
+    CHECK(H == state.H);
+  }
+  std::string rest;
+  in >> rest;
+  CHECK(rest.empty());
+
+  // write_row() (FileSink) writes the same lines
+  std::ostringstream rows;
+  rows << "x\ty\tH\n";
+  for (std::size_t i{0}; i < sim.evolution().size(); ++i) {
+    volterra::write_row(rows, i, sim.evolution()[i]);
+  }
+  CHECK(rows.str() == read_file(filename));
+
+  // formatting in parallel does not change the output (with 2 threads the
+  // rows take two batches, the second one reusing the buffers)
+  volterra::ThreadPool pool(2);
+  std::string const parallel = temporary("volterra_export_parallel.csv");
+  volterra::write_text(parallel, "x\ty\tH", std::span{sim.evolution()},
+                       pool);
+  CHECK(read_file(parallel) == read_file(filename));
+  std::remove(filename.c_str());
+  std::remove(parallel.c_str());
+}
+
+TEST_CASE("Testing the grid export is unchanged") {
+  wator::GridSimulation sim({40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1}, 11);
+  sim.go();
+  std::string const filename = temporary("wator_export.csv");
+  sim.save_grid_evolution(filename);
+
+  std::ostringstream expected;
+  expected << "step\tfish\tsharks\n";
+  for (std::size_t i{0}; i < sim.history().size(); ++i) {
+    expected << i << '\t' << sim.history()[i].fish << '\t'
+             << sim.history()[i].sharks << '\n';
+  }
+  CHECK(read_file(filename) == expected.str());
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Testing TextWriter with a small buffer") {
+  std::string const filename = temporary("text_writer.txt");
+  std::string expected;
+  {
+    volterra::TextWriter writer{filename, 1};  // at least max_row
+    for (int i = 0; i < 1000; ++i) {
+      std::string const line = std::to_string(i) + '\n';
+      writer.write(line);
+      expected += line;
+    }
+    std::string const long_line(1000, 'x');
+    writer.write(long_line);
+    expected += long_line;
+    writer.close();
+  }
+  CHECK(read_file(filename) == expected);
+  std::remove(filename.c_str());
+
+  CHECK_THROWS_AS(volterra::TextWriter{"/nonexistent/directory/file.txt"},
+                  std::runtime_error);
+}
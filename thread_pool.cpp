@@ -0,0 +1,141 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace volterra {
+
+namespace {
+
+// pool and deque of the worker running on this thread, if any
+thread_local ThreadPool const* current_pool{nullptr};
+thread_local std::size_t current_worker{0};
+
+}  // namespace
+
+//-------------------------CONSTRUCTORS-------------------------------
+
+ThreadPool::ThreadPool(std::size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (std::size_t i{0}; i < threads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (std::size_t i{0}; i < threads; ++i) {
+    workers_.emplace_back([this, i] { work(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    stop_ = true;
+  }
+  work_available_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+//--------------------------PUBLIC FUNCTIONS-----------------------
+
+// SUBMIT()
+void ThreadPool::submit(std::function<void()> task) {
+  std::size_t const target = current_pool == this
+                                 ? current_worker
+                                 : next_++ % queues_.size();
+  pending_.fetch_add(1);
+  {
+    // counted before the push, so that the fetch_sub() of a worker popping
+    // the task cannot come first and wrap queued_ around; the lock keeps a
+    // worker from missing the wake-up between its check of queued_ and its
+    // wait
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    queued_.fetch_add(1);
+  }
+  {
+    std::lock_guard<std::mutex> lock{queues_[target]->mutex};
+    queues_[target]->tasks.push_back(std::move(task));
+  }
+  work_available_.notify_one();
+}
+
+// WAIT()
+void ThreadPool::wait() {
+  // the calling task is itself pending: waiting would never end
+  if (current_pool == this) {
+    throw std::logic_error("wait() called from a task of the pool.");
+  }
+  std::unique_lock<std::mutex> lock{state_mutex_};
+  all_done_.wait(lock, [this] { return pending_.load() == 0; });
+  if (error_) {
+    std::exception_ptr error = std::exchange(error_, nullptr);
+    std::rethrow_exception(error);
+  }
+}
+
+//--------------------------PRIVATE FUNCTIONS-----------------------
+
+// TRY_POP()
+// Own deque from the back first, then the others from the front.
+bool ThreadPool::try_pop(std::size_t self, std::function<void()>& task) {
+  std::size_t const n = queues_.size();
+  for (std::size_t k{0}; k < n; ++k) {
+    Queue& queue = *queues_[(self + k) % n];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (queue.tasks.empty()) continue;
+    if (k == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    queued_.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+// RUN_ONE()
+bool ThreadPool::run_one() {
+  std::function<void()> task;
+  if (!try_pop(current_pool == this ? current_worker : 0, task)) return false;
+  run(task);
+  return true;
+}
+
+// RUN()
+void ThreadPool::run(std::function<void()>& task) {
+  try {
+    task();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    if (!error_) error_ = std::current_exception();
+  }
+  if (pending_.fetch_sub(1) == 1) {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    all_done_.notify_all();
+  }
+}
+
+// WORK()
+void ThreadPool::work(std::size_t self) {
+  current_pool = this;
+  current_worker = self;
+
+  while (true) {
+    std::function<void()> task;
+    if (try_pop(self, task)) {
+      run(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{state_mutex_};
+    work_available_.wait(lock,
+                         [this] { return stop_ || queued_.load() > 0; });
+    if (stop_ && queued_.load() == 0) return;
+  }
+}
+
+}  // namespace volterra
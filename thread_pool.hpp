@@ -0,0 +1,105 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace volterra {
+
+// --------------------------- CLASS ---------------------------
+
+// Fixed set of worker threads with one task deque each. submit() spreads
+// tasks round-robin (or onto the caller's own deque when called from a
+// task); a worker takes from the back of its deque and, when that is empty,
+// steals from the front of the others, so uneven tasks keep every core busy.
+// The first exception thrown by a task is rethrown by wait(). wait() covers
+// every task of the pool, so it cannot be called from a task; parallel_for()
+// waits for its own tasks only and can.
+class ThreadPool {
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> next_{0};     // round-robin target of submit()
+  std::atomic<std::size_t> queued_{0};   // tasks waiting in the deques
+  std::atomic<std::size_t> pending_{0};  // tasks submitted and not finished
+
+  std::mutex state_mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable all_done_;
+  bool stop_{false};
+  std::exception_ptr error_;
+
+  bool try_pop(std::size_t self, std::function<void()>& task);
+  void run(std::function<void()>& task);
+  void work(std::size_t self);
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  // threads = 0 uses one thread per hardware thread
+  explicit ThreadPool(std::size_t threads = 0);
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+  ~ThreadPool();
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  std::size_t size() const { return workers_.size(); }
+
+  void submit(std::function<void()> task);
+  // blocks until every submitted task (and the tasks they submit) is done;
+  // throws std::logic_error when called from a task of this pool
+  void wait();
+  // runs one queued task on the calling thread; false if there was none
+  bool run_one();
+};
+
+// Runs f(i) for i in [0, n) on the pool and waits for all of them, running
+// queued tasks meanwhile, so it can be called from a task of the same pool.
+// The first exception thrown by f is rethrown.
+template <typename F>
+void parallel_for(ThreadPool& pool, std::size_t n, F f) {
+  // shared with the tasks: the last one may still be notifying when the
+  // loop below sees remaining == 0 and returns
+  struct Batch {
+    std::atomic<std::size_t> remaining;
+    std::mutex mutex;
+    std::exception_ptr error;
+  };
+  auto batch = std::make_shared<Batch>();
+  batch->remaining.store(n);
+
+  for (std::size_t i{0}; i < n; ++i) {
+    pool.submit([&f, i, batch] {
+      try {
+        f(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock{batch->mutex};
+        if (!batch->error) batch->error = std::current_exception();
+      }
+      if (batch->remaining.fetch_sub(1) == 1) batch->remaining.notify_all();
+    });
+  }
+
+  std::size_t left = batch->remaining.load();
+  while (left != 0) {
+    // nothing queued: the tasks left are running on other threads
+    if (!pool.run_one()) batch->remaining.wait(left);
+    left = batch->remaining.load();
+  }
+  if (batch->error) std::rethrow_exception(batch->error);
+}
+
+}  // namespace volterra
+
+#endif
@@ -0,0 +1,254 @@
+#include "trajectory_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace volterra {
+
+namespace {
+
+constexpr std::array<char, 8> magic{'V', 'O', 'L', 'T', 'R', 'A', 'J', '\0'};
+constexpr std::uint32_t version{1};
+constexpr std::size_t chunk{8192};  // values gathered per write
+
+TrajectoryHeader make_header(TrajectoryKind kind, std::size_t count) {
+  TrajectoryHeader header{};
+  header.magic = magic;
+  header.version = version;
+  header.kind = kind;
+  header.count = count;
+  header.byte_order = 1;
+  return header;
+}
+
+std::ofstream open_output(std::string const& filename) {
+  std::ofstream out{filename, std::ios::binary};
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+  return out;
+}
+
+template <typename T>
+void write_values(std::ofstream& out, T const* values, std::size_t n) {
+  out.write(reinterpret_cast<char const*>(values),
+            static_cast<std::streamsize>(n * sizeof(T)));
+}
+
+// WRITE_COLUMN()
+// Gathers one field of the rows into a small buffer and writes it in chunks,
+// so the column is contiguous on disk without a full-size copy in memory.
+template <typename T, typename Row, typename Field>
+void write_column(std::ofstream& out, std::span<Row const> rows,
+                  Field field) {
+  std::vector<T> buffer(std::min(chunk, rows.size()));
+  for (std::size_t first{0}; first < rows.size(); first += chunk) {
+    std::size_t const n = std::min(chunk, rows.size() - first);
+    for (std::size_t i{0}; i < n; ++i) buffer[i] = field(rows[first + i]);
+    write_values(out, buffer.data(), n);
+  }
+}
+
+void finish(std::ofstream& out, std::string const& filename) {
+  out.close();
+  if (!out) throw std::runtime_error("Cannot write " + filename + ".");
+}
+
+}  // namespace
+
+//--------------------------FUNCTIONS-----------------------
+
+// WRITE_TRAJECTORY()
+void write_trajectory(std::string const& filename, Parameters const& p,
+                      double dt, std::span<State const> states) {
+  TrajectoryHeader header = make_header(TrajectoryKind::Continuous,
+                                        states.size());
+  header.dt = dt;
+  header.parameters = {p.a, p.b, p.c, p.d};
+
+  std::ofstream out = open_output(filename);
+  write_values(out, &header, 1);
+  write_column<double>(out, states, [](State const& s) { return s.t; });
+  write_column<double>(out, states, [](State const& s) { return s.x; });
+  write_column<double>(out, states, [](State const& s) { return s.y; });
+  write_column<double>(out, states, [](State const& s) { return s.H; });
+  finish(out, filename);
+}
+
+void write_trajectory(std::string const& filename,
+                      wator::GridParameters const& p, unsigned seed,
+                      std::span<wator::Population const> populations) {
+  TrajectoryHeader header = make_header(TrajectoryKind::Grid,
+                                        populations.size());
+  header.seed = seed;
+  header.parameters = {static_cast<double>(p.width),
+                       static_cast<double>(p.height),
+                       static_cast<double>(p.iterations),
+                       p.fish_density,
+                       p.sharks_density,
+                       static_cast<double>(p.fish_breed_age),
+                       static_cast<double>(p.sharks_initial_energy),
+                       static_cast<double>(p.sharks_breed_energy),
+                       static_cast<double>(p.sharks_food_energy),
+                       static_cast<double>(p.sharks_move_cost)};
+
+  std::ofstream out = open_output(filename);
+  write_values(out, &header, 1);
+  write_column<std::uint64_t>(
+      out, populations, [](wator::Population const& p_) { return p_.fish; });
+  write_column<std::uint64_t>(
+      out, populations,
+      [](wator::Population const& p_) { return p_.sharks; });
+  finish(out, filename);
+}
+
+void write_trajectory(std::string const& filename,
+                      wator::GridSimulation const& sim) {
+  write_trajectory(filename, sim.parameters(), sim.seed(), sim.history());
+}
+
+//-------------------------CONSTRUCTORS-------------------------------
+
+TrajectoryFile::TrajectoryFile(std::string const& filename) {
+  int const fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Cannot open " + filename + ".");
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot open " + filename + ".");
+  }
+  size_ = static_cast<std::size_t>(info.st_size);
+  if (size_ < sizeof(TrajectoryHeader)) {
+    ::close(fd);
+    throw std::runtime_error(filename + " is not a trajectory file.");
+  }
+
+  void* const mapping = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);  // the mapping keeps the file alive
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Cannot map " + filename + ".");
+  }
+  data_ = mapping;
+  header_ = *static_cast<TrajectoryHeader const*>(data_);
+
+  std::size_t const columns =
+      header_.kind == TrajectoryKind::Continuous ? 4
+      : header_.kind == TrajectoryKind::Grid     ? 2
+                                                 : 0;
+  bool const valid =
+      header_.magic == magic && header_.version == version &&
+      header_.byte_order == 1 && columns != 0 &&
+      header_.count <= (size_ - sizeof(TrajectoryHeader)) / (8 * columns) &&
+      size_ == sizeof(TrajectoryHeader) + 8 * columns * header_.count;
+  if (!valid) {
+    release();
+    throw std::runtime_error(filename + " is not a trajectory file.");
+  }
+}
+
+TrajectoryFile::TrajectoryFile(TrajectoryFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      header_(other.header_) {}
+
+TrajectoryFile& TrajectoryFile::operator=(TrajectoryFile&& other) noexcept {
+  if (this != &other) {
+    release();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    header_ = other.header_;
+  }
+  return *this;
+}
+
+TrajectoryFile::~TrajectoryFile() { release(); }
+
+//--------------------------PUBLIC FUNCTIONS-----------------------
+
+// PARAMETERS()
+Parameters TrajectoryFile::parameters() const {
+  if (kind() != TrajectoryKind::Continuous) {
+    throw std::logic_error("Not a continuous trajectory.");
+  }
+  auto const& p = header_.parameters;
+  return Parameters{p[0], p[1], p[2], p[3]};
+}
+
+// GRID_PARAMETERS()
+wator::GridParameters TrajectoryFile::grid_parameters() const {
+  if (kind() != TrajectoryKind::Grid) {
+    throw std::logic_error("Not a grid trajectory.");
+  }
+  auto const& p = header_.parameters;
+  return wator::GridParameters{static_cast<std::size_t>(p[0]),
+                               static_cast<std::size_t>(p[1]),
+                               static_cast<std::size_t>(p[2]),
+                               p[3],
+                               p[4],
+                               static_cast<int>(p[5]),
+                               static_cast<int>(p[6]),
+                               static_cast<int>(p[7]),
+                               static_cast<int>(p[8]),
+                               static_cast<int>(p[9])};
+}
+
+// COLUMNS
+std::span<double const> TrajectoryFile::t() const {
+  return column<double>(0);
+}
+std::span<double const> TrajectoryFile::x() const {
+  return column<double>(1);
+}
+std::span<double const> TrajectoryFile::y() const {
+  return column<double>(2);
+}
+std::span<double const> TrajectoryFile::H() const {
+  return column<double>(3);
+}
+std::span<std::uint64_t const> TrajectoryFile::fish() const {
+  return column<std::uint64_t>(0);
+}
+std::span<std::uint64_t const> TrajectoryFile::sharks() const {
+  return column<std::uint64_t>(1);
+}
+
+// STATE()
+State TrajectoryFile::state(std::size_t row) const {
+  return State{x()[row], y()[row], H()[row], t()[row]};
+}
+
+// POPULATION()
+wator::Population TrajectoryFile::population(std::size_t row) const {
+  return wator::Population{fish()[row], sharks()[row]};
+}
+
+//--------------------------PRIVATE FUNCTIONS-----------------------
+
+// COLUMN()
+template <typename T>
+std::span<T const> TrajectoryFile::column(std::size_t index) const {
+  bool const continuous = std::is_same_v<T, double>;
+  if (continuous != (kind() == TrajectoryKind::Continuous)) {
+    throw std::logic_error("No such column in this trajectory.");
+  }
+  auto const* first = reinterpret_cast<T const*>(
+      static_cast<char const*>(data_) + sizeof(TrajectoryHeader));
+  return std::span<T const>{first + index * count(), count()};
+}
+
+// RELEASE()
+void TrajectoryFile::release() {
+  if (data_ != nullptr) ::munmap(const_cast<void*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace volterra
@@ -0,0 +1,108 @@
+#ifndef TRAJECTORY_FILE_HPP
+#define TRAJECTORY_FILE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "grid_simulation.hpp"
+#include "simulation.hpp"
+
+namespace volterra {
+
+// --------------------------- STRUCT ---------------------------
+
+enum class TrajectoryKind : std::uint32_t { Continuous = 1, Grid = 2 };
+
+// Binary trajectory: this 128-byte header, then one contiguous column per
+// field, count values each, in native byte order:
+//   Continuous: t, x, y, H (double)
+//   Grid:       fish, sharks (uint64)
+// parameters holds a, b, c, d for a continuous run, the ten GridParameters
+// fields in declaration order for a grid run.
+struct TrajectoryHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  TrajectoryKind kind;
+  std::uint64_t count;  // rows, i.e. states or populations
+  std::uint64_t seed;   // grid only
+  double dt;            // continuous only
+  std::array<double, 10> parameters;
+  std::uint32_t byte_order;  // 1 when read with the writer's byte order
+  std::uint32_t reserved;
+};
+static_assert(sizeof(TrajectoryHeader) == 128);
+
+// --------------------------- FUNCTIONS ---------------------------
+
+// write a whole trajectory; throw std::runtime_error if the file cannot be
+// written
+void write_trajectory(std::string const& filename, Parameters const& p,
+                      double dt, std::span<State const> states);
+void write_trajectory(std::string const& filename,
+                      wator::GridParameters const& p, unsigned seed,
+                      std::span<wator::Population const> populations);
+
+// the states or populations kept in memory by a simulation
+template <typename Integrator>
+void write_trajectory(std::string const& filename,
+                      BasicSimulation<Integrator> const& sim) {
+  write_trajectory(filename, sim.parameters(), sim.timescale(),
+                   sim.evolution());
+}
+void write_trajectory(std::string const& filename,
+                      wator::GridSimulation const& sim);
+
+// --------------------------- CLASS ---------------------------
+
+// Read-only view of a trajectory file. The file is memory-mapped and the
+// columns are spans straight into the mapping: nothing is copied or parsed,
+// and pages are only read when touched. The spans live as long as the
+// TrajectoryFile. Throws std::runtime_error if the file cannot be mapped or
+// is not a valid trajectory.
+class TrajectoryFile {
+  void const* data_{nullptr};
+  std::size_t size_{0};
+  TrajectoryHeader header_{};
+
+  template <typename T>
+  std::span<T const> column(std::size_t index) const;
+  void release();
+
+ public:
+  //-------------------------CONSTRUCTOR------------------------------
+  explicit TrajectoryFile(std::string const& filename);
+  TrajectoryFile(TrajectoryFile&& other) noexcept;
+  TrajectoryFile& operator=(TrajectoryFile&& other) noexcept;
+  TrajectoryFile(TrajectoryFile const&) = delete;
+  TrajectoryFile& operator=(TrajectoryFile const&) = delete;
+  ~TrajectoryFile();
+
+  //-----------------------PUBLIC FUNCTIONS-------------------------
+  TrajectoryHeader const& header() const { return header_; }
+  TrajectoryKind kind() const { return header_.kind; }
+  std::size_t count() const { return header_.count; }
+  double dt() const { return header_.dt; }
+  unsigned seed() const { return static_cast<unsigned>(header_.seed); }
+  // throw std::logic_error for the wrong kind of file
+  Parameters parameters() const;
+  wator::GridParameters grid_parameters() const;
+
+  // continuous columns
+  std::span<double const> t() const;
+  std::span<double const> x() const;
+  std::span<double const> y() const;
+  std::span<double const> H() const;
+  State state(std::size_t row) const;
+
+  // grid columns
+  std::span<std::uint64_t const> fish() const;
+  std::span<std::uint64_t const> sharks() const;
+  wator::Population population(std::size_t row) const;
+};
+
+}  // namespace volterra
+
+#endif
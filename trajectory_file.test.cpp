@@ -0,0 +1,83 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "trajectory_file.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "doctest.h"
+#include "test_files.hpp"
+
+TEST_CASE("Testing a continuous trajectory round trip") {
+  volterra::Parameters const p{1., 0.5, 0.2, 0.8};
+  volterra::AdaptiveSimulation sim(p, 3., 2., 0.01, 3000.);
+  sim.go();
+  std::string const filename = temporary("volterra_trajectory.bin");
+  volterra::write_trajectory(filename, sim);
+
+  volterra::TrajectoryFile file(filename);
+  CHECK(file.kind() == volterra::TrajectoryKind::Continuous);
+  CHECK(std::filesystem::file_size(filename) == 128 + 4 * 8 * 3000);
+  REQUIRE(file.count() == 3000);
+  CHECK(file.dt() == 0.01);
+  CHECK(file.parameters() == p);
+  CHECK_THROWS_AS(file.grid_parameters(), std::logic_error);
+  CHECK_THROWS_AS(file.fish(), std::logic_error);
+
+  auto const& evolution = sim.evolution();
+  auto const t = file.t();
+  auto const x = file.x();
+  REQUIRE(t.size() == 3000);
+  for (std::size_t i{0}; i < evolution.size(); ++i) {
+    CHECK(t[i] == evolution[i].t);
+    CHECK(x[i] == evolution[i].x);
+    CHECK(file.y()[i] == evolution[i].y);
+    CHECK(file.H()[i] == evolution[i].H);
+  }
+  CHECK(file.state(2999).t == evolution.back().t);
+
+  // the views move with the mapping
+  volterra::TrajectoryFile moved(std::move(file));
+  CHECK(moved.x().data() == x.data());
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Testing a grid trajectory round trip") {
+  wator::GridParameters const p{40, 30, 25, 0.4, 0.02, 3, 4, 10, 2, 1};
+  wator::GridSimulation sim(p, 11);
+  sim.go();
+  std::string const filename = temporary("wator_trajectory.bin");
+  volterra::write_trajectory(filename, sim);
+
+  volterra::TrajectoryFile const file(filename);
+  CHECK(file.kind() == volterra::TrajectoryKind::Grid);
+  REQUIRE(file.count() == 25);
+  CHECK(file.seed() == 11);
+  CHECK(file.grid_parameters() == p);
+  CHECK_THROWS_AS(file.parameters(), std::logic_error);
+  for (std::size_t i{0}; i < 25; ++i) {
+    CHECK(file.population(i) == sim.history()[i]);
+  }
+  std::remove(filename.c_str());
+}
+
+TEST_CASE("Testing invalid trajectory files") {
+  CHECK_THROWS_AS(volterra::TrajectoryFile{temporary("missing.bin")},
+                  std::runtime_error);
+
+  std::string const filename = temporary("not_a_trajectory.bin");
+  {
+    std::ofstream out{filename};
+    out << "t\tx\ty\tH\n";
+  }
+  CHECK_THROWS_AS(volterra::TrajectoryFile{filename}, std::runtime_error);
+
+  // truncated file
+  std::vector<volterra::State> const states(10, volterra::State{1., 2., 3.});
+  volterra::write_trajectory(filename, {1., 1., 1., 1.}, 0.1, states);
+  CHECK_NOTHROW(volterra::TrajectoryFile{filename});
+  std::filesystem::resize_file(filename, 128 + 4 * 8 * 10 - 8);
+  CHECK_THROWS_AS(volterra::TrajectoryFile{filename}, std::runtime_error);
+  std::remove(filename.c_str());
+}